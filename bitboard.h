@@ -0,0 +1,170 @@
+#ifndef BITBOARD_H_INCLUDED
+#define BITBOARD_H_INCLUDED
+/* bitboard.h
+ * Fixed size bit sets covering a square board, stored as 64 bit words. The
+ * board width is set at compile time with BITBOARD_WIDTH (16 if not given) so
+ * every loop over the words has a constant trip count. Square index is
+ * (row * width) + column and stepping to a neighbor is a plain shift.
+ * Everything is inline, these are meant to be passed around by value.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef BITBOARD_WIDTH
+#define BITBOARD_WIDTH 16
+#endif
+#if BITBOARD_WIDTH < 3 || BITBOARD_WIDTH > 16
+#error "BITBOARD_WIDTH must be between 3 and 16"
+#endif
+
+#define BITBOARD_CELLS (BITBOARD_WIDTH * BITBOARD_WIDTH)
+#define BITBOARD_WORDS ((BITBOARD_CELLS + 63) / 64)
+
+/* Constant masks for any width. A mask is built one bit at a time from a test
+ * on the square index, the compiler folds all of it down to plain constants.
+ */
+#define BITBOARD_MASK_BIT(word, bit, test) \
+  ((test((64 * (word)) + (bit))) ? (1ULL << (bit)) : 0ULL)
+#define BITBOARD_MASK_4(word, bit, test)                                 \
+  (BITBOARD_MASK_BIT(word, bit, test) |                                 \
+   BITBOARD_MASK_BIT(word, (bit) + 1, test) |                           \
+   BITBOARD_MASK_BIT(word, (bit) + 2, test) |                           \
+   BITBOARD_MASK_BIT(word, (bit) + 3, test))
+#define BITBOARD_MASK_16(word, bit, test)       \
+  (BITBOARD_MASK_4(word, bit, test) |          \
+   BITBOARD_MASK_4(word, (bit) + 4, test) |    \
+   BITBOARD_MASK_4(word, (bit) + 8, test) |    \
+   BITBOARD_MASK_4(word, (bit) + 12, test))
+#define BITBOARD_MASK_WORD(word, test)                                 \
+  (BITBOARD_MASK_16(word, 0, test) | BITBOARD_MASK_16(word, 16, test) | \
+   BITBOARD_MASK_16(word, 32, test) | BITBOARD_MASK_16(word, 48, test))
+
+#if BITBOARD_WORDS == 1
+#define BITBOARD_MASK(test) {{BITBOARD_MASK_WORD(0, test)}}
+#elif BITBOARD_WORDS == 2
+#define BITBOARD_MASK(test) \
+  {{BITBOARD_MASK_WORD(0, test), BITBOARD_MASK_WORD(1, test)}}
+#elif BITBOARD_WORDS == 3
+#define BITBOARD_MASK(test)                                    \
+  {{BITBOARD_MASK_WORD(0, test), BITBOARD_MASK_WORD(1, test), \
+    BITBOARD_MASK_WORD(2, test)}}
+#else
+#define BITBOARD_MASK(test)                                    \
+  {{BITBOARD_MASK_WORD(0, test), BITBOARD_MASK_WORD(1, test), \
+    BITBOARD_MASK_WORD(2, test), BITBOARD_MASK_WORD(3, test)}}
+#endif
+
+// tests for BITBOARD_MASK, every square on the board, and every square except
+// the ones in the first / last column. The column masks stop shifts from
+// wrapping around to the other side of the board.
+#define BITBOARD_ON_BOARD(index) ((index) < BITBOARD_CELLS)
+#define BITBOARD_NOT_FIRST_COL(index) \
+  (BITBOARD_ON_BOARD(index) && (index) % BITBOARD_WIDTH != 0)
+#define BITBOARD_NOT_LAST_COL(index) \
+  (BITBOARD_ON_BOARD(index) && (index) % BITBOARD_WIDTH != BITBOARD_WIDTH - 1)
+
+typedef struct {
+  uint64_t words[BITBOARD_WORDS];
+} bitboard_T;
+
+static inline bitboard_T bitboard_empty(void) {
+  bitboard_T set = {{0}};
+  return set;
+}
+
+static inline bool bitboard_getbit(const bitboard_T* set, int index) {
+  return (set->words[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline void bitboard_setbit(bitboard_T* set, int index) {
+  set->words[index >> 6] |= 1ULL << (index & 63);
+}
+
+static inline void bitboard_clearbit(bitboard_T* set, int index) {
+  set->words[index >> 6] &= ~(1ULL << (index & 63));
+}
+
+static inline bitboard_T bitboard_and(bitboard_T a, bitboard_T b) {
+  for (int i = 0; i < BITBOARD_WORDS; i++) a.words[i] &= b.words[i];
+  return a;
+}
+
+static inline bitboard_T bitboard_or(bitboard_T a, bitboard_T b) {
+  for (int i = 0; i < BITBOARD_WORDS; i++) a.words[i] |= b.words[i];
+  return a;
+}
+
+/**
+ * @brief a AND NOT b, everything in a that isn't in b.
+ */
+static inline bitboard_T bitboard_andnot(bitboard_T a, bitboard_T b) {
+  for (int i = 0; i < BITBOARD_WORDS; i++) a.words[i] &= ~b.words[i];
+  return a;
+}
+
+static inline bool bitboard_any(bitboard_T set) {
+  uint64_t any = 0;
+  for (int i = 0; i < BITBOARD_WORDS; i++) any |= set.words[i];
+  return any != 0;
+}
+
+static inline bool bitboard_equal(bitboard_T a, bitboard_T b) {
+  uint64_t diff = 0;
+  for (int i = 0; i < BITBOARD_WORDS; i++) diff |= a.words[i] ^ b.words[i];
+  return diff == 0;
+}
+
+static inline int bitboard_popcount(bitboard_T set) {
+  int count = 0;
+  for (int i = 0; i < BITBOARD_WORDS; i++)
+    count += __builtin_popcountll(set.words[i]);
+  return count;
+}
+
+/**
+ * @brief Removes the lowest set bit from the set and returns its index.
+ * The set must not be empty.
+ */
+static inline int bitboard_pop_first(bitboard_T* set) {
+  for (int i = 0;; i++)
+    if (set->words[i]) {
+      int bit = __builtin_ctzll(set->words[i]);
+      set->words[i] &= set->words[i] - 1;
+      return (i << 6) + bit;
+    }
+}
+
+/**
+ * @brief Moves every bit in the set by (dy, dx) squares, dy and dx must be
+ * -1, 0 or 1. Bits that would leave the board are dropped.
+ */
+static inline bitboard_T bitboard_step(bitboard_T set, int dy, int dx) {
+  static const bitboard_T on_board = BITBOARD_MASK(BITBOARD_ON_BOARD);
+  static const bitboard_T not_first_col =
+      BITBOARD_MASK(BITBOARD_NOT_FIRST_COL);
+  static const bitboard_T not_last_col = BITBOARD_MASK(BITBOARD_NOT_LAST_COL);
+  int shift = (dy * BITBOARD_WIDTH) + dx;
+  bitboard_T out;
+  if (shift > 0) {
+    for (int i = BITBOARD_WORDS - 1; i > 0; i--)
+      out.words[i] =
+          (set.words[i] << shift) | (set.words[i - 1] >> (64 - shift));
+    out.words[0] = set.words[0] << shift;
+    // anything pushed past the last square fell off the board
+    out = bitboard_and(out, on_board);
+  } else if (shift < 0) {
+    shift = -shift;
+    for (int i = 0; i < BITBOARD_WORDS - 1; i++)
+      out.words[i] =
+          (set.words[i] >> shift) | (set.words[i + 1] << (64 - shift));
+    out.words[BITBOARD_WORDS - 1] = set.words[BITBOARD_WORDS - 1] >> shift;
+  } else {
+    return set;
+  }
+  // anything that moved right and landed in column 0 wrapped, same for left
+  if (dx > 0) out = bitboard_and(out, not_first_col);
+  if (dx < 0) out = bitboard_and(out, not_last_col);
+  return out;
+}
+
+#endif /* BITBOARD_H_INCLUDED */
@@ -2,81 +2,300 @@
 
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITMASK_X86
+#include <immintrin.h>
+#endif
+
+// index of the bit in the row major layout, and which block it ends up in
+#define bit_offset(mask, index_y, index_x) \
+  (((mask)->size_x * (index_y)) + (index_x))
+#define bit_block(offset) ((offset) / BITBLOCK_BITS)
+#define bit_in_block(offset) ((bitblock_T)1 << ((offset) % BITBLOCK_BITS))
+
+static unsigned long bitmask_blocks(bitmask_T *mask) {
+  return BITMASK_BLOCKS(mask->size_y, mask->size_x);
+}
+
+/* Bulk operations
+ * Every operation over whole masks has a plain version that works a block at
+ * a time, and on x86 SSE2 and AVX2 versions that work 2 or 4 blocks at a time.
+ * Which ones get used is decided once when the program starts, based on what
+ * the CPU supports.
+ */
+
+enum bitmask_op { BITMASK_AND, BITMASK_OR, BITMASK_XOR, BITMASK_ANDNOT };
+
+static void combine_scalar(bitblock_T *result, const bitblock_T *mask,
+                           unsigned long blocks, enum bitmask_op op) {
+  for (unsigned long i = 0; i < blocks; i++) switch (op) {
+      case BITMASK_AND:
+        result[i] &= mask[i];
+        break;
+      case BITMASK_OR:
+        result[i] |= mask[i];
+        break;
+      case BITMASK_XOR:
+        result[i] ^= mask[i];
+        break;
+      case BITMASK_ANDNOT:
+        result[i] &= ~mask[i];
+        break;
+    }
+}
+
+static bool any_scalar(const bitblock_T *bits, unsigned long blocks) {
+  for (unsigned long i = 0; i < blocks; i++)
+    if (bits[i]) return true;
+  return false;
+}
+
+static unsigned long count_scalar(const bitblock_T *bits,
+                                  unsigned long blocks) {
+  unsigned long count = 0;
+  for (unsigned long i = 0; i < blocks; i++)
+    count += __builtin_popcountll(bits[i]);
+  return count;
+}
+
+#ifdef BITMASK_X86
+static void combine_sse2(bitblock_T *result, const bitblock_T *mask,
+                         unsigned long blocks, enum bitmask_op op) {
+  unsigned long i = 0;
+  for (; i + 2 <= blocks; i += 2) {
+    __m128i a = _mm_loadu_si128((const __m128i *)&result[i]);
+    __m128i b = _mm_loadu_si128((const __m128i *)&mask[i]);
+    switch (op) {
+      case BITMASK_AND:
+        a = _mm_and_si128(a, b);
+        break;
+      case BITMASK_OR:
+        a = _mm_or_si128(a, b);
+        break;
+      case BITMASK_XOR:
+        a = _mm_xor_si128(a, b);
+        break;
+      case BITMASK_ANDNOT:
+        a = _mm_andnot_si128(b, a);
+        break;
+    }
+    _mm_storeu_si128((__m128i *)&result[i], a);
+  }
+  combine_scalar(&result[i], &mask[i], blocks - i, op);
+}
+
+static bool any_sse2(const bitblock_T *bits, unsigned long blocks) {
+  unsigned long i = 0;
+  __m128i any = _mm_setzero_si128();
+  for (; i + 2 <= blocks; i += 2)
+    any = _mm_or_si128(any, _mm_loadu_si128((const __m128i *)&bits[i]));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF)
+    return true;
+  return any_scalar(&bits[i], blocks - i);
+}
+
+__attribute__((target("avx2"))) static void combine_avx2(
+    bitblock_T *result, const bitblock_T *mask, unsigned long blocks,
+    enum bitmask_op op) {
+  unsigned long i = 0;
+  for (; i + 4 <= blocks; i += 4) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)&result[i]);
+    __m256i b = _mm256_loadu_si256((const __m256i *)&mask[i]);
+    switch (op) {
+      case BITMASK_AND:
+        a = _mm256_and_si256(a, b);
+        break;
+      case BITMASK_OR:
+        a = _mm256_or_si256(a, b);
+        break;
+      case BITMASK_XOR:
+        a = _mm256_xor_si256(a, b);
+        break;
+      case BITMASK_ANDNOT:
+        a = _mm256_andnot_si256(b, a);
+        break;
+    }
+    _mm256_storeu_si256((__m256i *)&result[i], a);
+  }
+  combine_scalar(&result[i], &mask[i], blocks - i, op);
+}
+
+__attribute__((target("avx2"))) static bool any_avx2(const bitblock_T *bits,
+                                                     unsigned long blocks) {
+  unsigned long i = 0;
+  __m256i any = _mm256_setzero_si256();
+  for (; i + 4 <= blocks; i += 4)
+    any = _mm256_or_si256(any, _mm256_loadu_si256((const __m256i *)&bits[i]));
+  if (!_mm256_testz_si256(any, any)) return true;
+  return any_scalar(&bits[i], blocks - i);
+}
+
+/* AVX2 has no popcount instruction, this counts each nibble with a shuffle
+ * lookup and then adds the bytes up with a sum of absolute differences.
+ */
+__attribute__((target("avx2,popcnt"))) static unsigned long count_avx2(
+    const bitblock_T *bits, unsigned long blocks) {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+  __m256i total = _mm256_setzero_si256();
+  unsigned long i = 0;
+  for (; i + 4 <= blocks; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&bits[i]);
+    __m256i low = _mm256_and_si256(v, low_nibbles);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibbles);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                    _mm256_shuffle_epi8(lookup, high));
+    total = _mm256_add_epi64(total,
+                             _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+  unsigned long count = _mm256_extract_epi64(total, 0) +
+                        _mm256_extract_epi64(total, 1) +
+                        _mm256_extract_epi64(total, 2) +
+                        _mm256_extract_epi64(total, 3);
+  for (; i < blocks; i++) count += _mm_popcnt_u64(bits[i]);
+  return count;
+}
+#endif
+
+static struct {
+  void (*combine)(bitblock_T *, const bitblock_T *, unsigned long,
+                  enum bitmask_op);
+  bool (*any)(const bitblock_T *, unsigned long);
+  unsigned long (*count)(const bitblock_T *, unsigned long);
+} bulk = {combine_scalar, any_scalar, count_scalar};
+
+#ifdef BITMASK_X86
+__attribute__((constructor)) static void bitmask_pick_bulk(void) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) {
+    bulk.combine = combine_sse2;
+    bulk.any = any_sse2;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    bulk.combine = combine_avx2;
+    bulk.any = any_avx2;
+    if (__builtin_cpu_supports("popcnt")) bulk.count = count_avx2;
+  }
+}
+#endif
 
 bitmask_T *create_bitmask(bitindex_T size_y, bitindex_T size_x) {
   // calculate number of blocks needed
-  // integer division rounds down, the part after the + checks if there is a
-  // remainder and adds one if there is
-  unsigned long blocks =
-      ((size_y * size_x) / CHAR_BIT) + !!((size_y * size_x) % CHAR_BIT);
-  if (blocks > BITINDEX_T_MAX) return NULL;  // TOO BIG!
+  unsigned long long blocks = BITMASK_BLOCKS(size_y, size_x);
+  // the offset of every bit has to fit in a bitindex_T
+  if ((unsigned long long)size_y * size_x > BITINDEX_T_MAX)
+    return NULL;  // TOO BIG!
   // allocate memory and assign variables
   bitmask_T *mask = malloc(sizeof(bitmask_T));
   if (mask == NULL) exit(39);
-  mask->bits =
-      calloc(blocks, sizeof(unsigned char));  // sizeof char is always 1
+  mask->bits = calloc(blocks, sizeof(bitblock_T));
+  if (mask->bits == NULL) exit(39);
   mask->size_y = size_y;
   mask->size_x = size_x;
 
   return mask;
 }
 
-bool getbit(bitmask_T *mask, bitindex_T index_y, bitindex_T index_x) {
-  bitindex_T block = ((mask->size_x * index_y) + index_x) / CHAR_BIT;
-  unsigned char byte = mask->bits[block];
-  byte = byte >> ((mask->size_x * index_y) + index_x) % CHAR_BIT;
-  byte &= 1;
+void init_bitmask(bitmask_T *mask, bitblock_T *storage, bitindex_T size_y,
+                  bitindex_T size_x) {
+  mask->bits = storage;
+  mask->size_y = size_y;
+  mask->size_x = size_x;
+  reset_bitmask(mask);
+}
 
-  // its already only going to be 1 or 0
-  return byte;
+bool getbit(bitmask_T *mask, bitindex_T index_y, bitindex_T index_x) {
+  bitindex_T offset = bit_offset(mask, index_y, index_x);
+  return !!(mask->bits[bit_block(offset)] & bit_in_block(offset));
 }
 
 void setbit(bitmask_T *mask, bitindex_T index_y, bitindex_T index_x) {
-  bitindex_T block =
-      ((mask->size_x * index_y) + index_x) / CHAR_BIT;  // index in our array
-  unsigned char byte = 1;
-  byte = byte << ((mask->size_x * index_y) + index_x) % CHAR_BIT;
-  mask->bits[block] |= byte;
-}
-
-/* If anyone is wondering the performance delta between using getsetbit vs
- * getbit then setbit, with an x86_64 target using -Os and -S GCC's assembler
- * output gave getbit and setbit 14 assembly instructions each while getsetbit
- * was 20 instructions. This doesn't count the instructions needed to set up
- * the function calls or the call frame macro things.
- */
+  bitindex_T offset = bit_offset(mask, index_y, index_x);
+  mask->bits[bit_block(offset)] |= bit_in_block(offset);
+}
 
 bool getsetbit(bitmask_T *mask, bitindex_T index_y, bitindex_T index_x) {
-  bitindex_T block =
-      ((mask->size_x * index_y) + index_x) / CHAR_BIT;  // index in our array
-  unsigned char byte = 1;
-  byte = byte << ((mask->size_x * index_y) + index_x) % CHAR_BIT;
+  bitindex_T offset = bit_offset(mask, index_y, index_x);
+  bitblock_T bit = bit_in_block(offset);
   // conversion is just to be extra safe
-  bool ret = !!(mask->bits[block] & byte);
-  mask->bits[block] |= byte;
+  bool ret = !!(mask->bits[bit_block(offset)] & bit);
+  mask->bits[bit_block(offset)] |= bit;
   return ret;
 }
 
 void togglebit(bitmask_T *mask, bitindex_T index_y, bitindex_T index_x) {
-  bitindex_T block =
-      ((mask->size_x * index_y) + index_x) / CHAR_BIT;  // index in our array
-  unsigned char byte = 1;
-  byte = byte << ((mask->size_x * index_y) + index_x) % CHAR_BIT;
-  mask->bits[block] ^= byte;
+  bitindex_T offset = bit_offset(mask, index_y, index_x);
+  mask->bits[bit_block(offset)] ^= bit_in_block(offset);
+}
+
+void andmask(bitmask_T *result, bitmask_T *mask) {
+  bulk.combine(result->bits, mask->bits, bitmask_blocks(result), BITMASK_AND);
+}
+
+void ormask(bitmask_T *result, bitmask_T *mask) {
+  bulk.combine(result->bits, mask->bits, bitmask_blocks(result), BITMASK_OR);
+}
+
+void xormask(bitmask_T *result, bitmask_T *mask) {
+  bulk.combine(result->bits, mask->bits, bitmask_blocks(result), BITMASK_XOR);
+}
+
+void andnotmask(bitmask_T *result, bitmask_T *mask) {
+  bulk.combine(result->bits, mask->bits, bitmask_blocks(result),
+               BITMASK_ANDNOT);
 }
 
 bool anybit(bitmask_T *mask) {
-  bitindex_T blocks = ((mask->size_y * mask->size_x) / CHAR_BIT) +
-                      !!((mask->size_y * mask->size_x) % CHAR_BIT);
-  for (bitindex_T i = 0; i < blocks; i++)
-    if (mask->bits[i]) return true;
-  return false;
+  return bulk.any(mask->bits, bitmask_blocks(mask));
+}
+
+unsigned long countbits(bitmask_T *mask) {
+  return bulk.count(mask->bits, bitmask_blocks(mask));
+}
+
+/**
+ * @brief Finds the first true bit at or after offset, returns false if there
+ * isn't one.
+ */
+static bool bit_search(bitmask_T *mask, unsigned long long offset,
+                       bitindex_T *index_y, bitindex_T *index_x) {
+  unsigned long long size = (unsigned long long)mask->size_y * mask->size_x;
+  if (offset >= size) return false;
+  unsigned long blocks = bitmask_blocks(mask);
+  unsigned long block = bit_block(offset);
+  // drop the bits before offset in the first block we look at
+  bitblock_T bits =
+      mask->bits[block] & (~(bitblock_T)0 << (offset % BITBLOCK_BITS));
+  while (!bits) {
+    if (++block == blocks) return false;
+    bits = mask->bits[block];
+  }
+  offset = ((unsigned long long)block * BITBLOCK_BITS) + __builtin_ctzll(bits);
+  if (offset >= size) return false;
+  *index_y = offset / mask->size_x;
+  *index_x = offset % mask->size_x;
+  return true;
+}
+
+bool firstbit(bitmask_T *mask, bitindex_T *index_y, bitindex_T *index_x) {
+  return bit_search(mask, 0, index_y, index_x);
+}
+
+bool nextbit(bitmask_T *mask, bitindex_T *index_y, bitindex_T *index_x) {
+  return bit_search(mask, bit_offset(mask, *index_y, *index_x) + 1ULL, index_y,
+                    index_x);
+}
+
+void load_bitmask(bitmask_T *mask, const bitblock_T *blocks) {
+  memcpy(mask->bits, blocks, bitmask_blocks(mask) * sizeof(bitblock_T));
 }
 
 void reset_bitmask(bitmask_T *mask) {
-  bitindex_T blocks = ((mask->size_y * mask->size_x) / CHAR_BIT) +
-                      !!((mask->size_y * mask->size_x) % CHAR_BIT);
-  for (bitindex_T i = 0; i < blocks; i++) mask->bits[i] = 0;
+  memset(mask->bits, 0, bitmask_blocks(mask) * sizeof(bitblock_T));
 }
 
 void destroy_bitmask(bitmask_T *mask) {
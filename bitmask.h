@@ -3,19 +3,35 @@
 /* bitmask.h
  * Library for creating simple 2D bitmasks. Two dimensional arrays of single
  * bits. Useful for board games in memory-constrained enviroments.
+ * Bits are stored row major in 64 bit blocks, bulk operations work a block (or
+ * a SIMD register of blocks, picked when the program starts) at a time.
  */
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-typedef unsigned short bitindex_T;
-#define BITINDEX_T_MAX USHRT_MAX
+typedef uint32_t bitindex_T;
+#define BITINDEX_T_MAX UINT32_MAX
+
+typedef uint64_t bitblock_T;
+#define BITBLOCK_BITS 64
+
+/**
+ * @brief Number of blocks needed to store a size_y by size_x bitmask, for when
+ * you want to provide the storage yourself with init_bitmask.
+ * Integer division rounds down, the part after the + checks if there is a
+ * remainder and adds one if there is.
+ */
+#define BITMASK_BLOCKS(size_y, size_x)                             \
+  ((((unsigned long long)(size_y) * (size_x)) / BITBLOCK_BITS) + \
+   !!(((unsigned long long)(size_y) * (size_x)) % BITBLOCK_BITS))
 
 /**
  * @brief Struct that holds bitmask and supporting data.
  * Avoid accessing if you can help it, this is supposed to be opaque.
  */
 typedef struct {
-  unsigned char* bits;
+  bitblock_T* bits;
   bitindex_T size_y;
   bitindex_T size_x;
 } bitmask_T;
@@ -26,10 +42,24 @@ typedef struct {
  *
  * @param size_y Number of rows of bits to store.
  * @param size_x Number of columns of bits to store.
- * @return Bitmask, allocated on the heap.
+ * @return Bitmask, allocated on the heap. NULL if it would be too big.
  */
 bitmask_T* create_bitmask(bitindex_T size_y, bitindex_T size_x);
 
+/**
+ * @brief Initialize a bitmask on storage you own, no allocation is done.
+ * Bitmask will be initialized to all zeros/false. Don't call destroy_bitmask
+ * on it.
+ *
+ * @param mask Bitmask to initialize.
+ * @param storage At least BITMASK_BLOCKS(size_y, size_x) blocks to keep the
+ * bits in.
+ * @param size_y Number of rows of bits to store.
+ * @param size_x Number of columns of bits to store.
+ */
+void init_bitmask(bitmask_T* mask, bitblock_T* storage, bitindex_T size_y,
+                  bitindex_T size_x);
+
 /**
  * @brief Gets the value of a bit at a specified index.
  * This function does NOT perform bounds checking.
@@ -69,12 +99,41 @@ void togglebit(bitmask_T* mask, bitindex_T index_y, bitindex_T index_x);
 
 /**
  * @brief AND's two masks together. The result is only stored in the result mask.
- * 
+ * Both masks need to be the same size.
+ *
  * @param result bitmask to AND, this is the only one that gets modified
  * @param mask AND mask
  */
 void andmask(bitmask_T* result, bitmask_T* mask);
 
+/**
+ * @brief OR's two masks together. The result is only stored in the result mask.
+ * Both masks need to be the same size.
+ *
+ * @param result bitmask to OR, this is the only one that gets modified
+ * @param mask OR mask
+ */
+void ormask(bitmask_T* result, bitmask_T* mask);
+
+/**
+ * @brief XOR's two masks together. The result is only stored in the result
+ * mask. Both masks need to be the same size.
+ *
+ * @param result bitmask to XOR, this is the only one that gets modified
+ * @param mask XOR mask
+ */
+void xormask(bitmask_T* result, bitmask_T* mask);
+
+/**
+ * @brief Clears every bit in result that is set in mask (result AND NOT mask).
+ * Both masks need to be the same size.
+ *
+ * @param result bitmask to clear bits from, this is the only one that gets
+ * modified
+ * @param mask bits to clear
+ */
+void andnotmask(bitmask_T* result, bitmask_T* mask);
+
 /**
  * @brief Checks to see if any bit inside of the mask is true.
  *
@@ -84,6 +143,45 @@ void andmask(bitmask_T* result, bitmask_T* mask);
  */
 bool anybit(bitmask_T* mask);
 
+/**
+ * @brief Counts how many bits in the mask are true.
+ *
+ * @param mask Mask to count.
+ * @return unsigned long number of true bits.
+ */
+unsigned long countbits(bitmask_T* mask);
+
+/**
+ * @brief Finds the first true bit in the mask, going row by row.
+ *
+ * @param mask Mask to search.
+ * @param index_y Set to the row of the bit found.
+ * @param index_x Set to the column of the bit found.
+ * @return true if a bit was found, false if the mask is empty.
+ */
+bool firstbit(bitmask_T* mask, bitindex_T* index_y, bitindex_T* index_x);
+
+/**
+ * @brief Finds the next true bit after [index_y][index_x], going row by row.
+ * Together with firstbit this walks every true bit:
+ * for (bool found = firstbit(m, &y, &x); found; found = nextbit(m, &y, &x))
+ *
+ * @param mask Mask to search.
+ * @param index_y Row to search after, set to the row of the bit found.
+ * @param index_x Column to search after, set to the column of the bit found.
+ * @return true if a bit was found, false if there are no more.
+ */
+bool nextbit(bitmask_T* mask, bitindex_T* index_y, bitindex_T* index_x);
+
+/**
+ * @brief Overwrites the whole mask with raw blocks, in the same row major
+ * layout the mask stores them in.
+ *
+ * @param mask Mask to overwrite.
+ * @param blocks BITMASK_BLOCKS(size_y, size_x) blocks to copy in.
+ */
+void load_bitmask(bitmask_T* mask, const bitblock_T* blocks);
+
 /**
  * @brief Resets entime bitmask back to zero.
  *
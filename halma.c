@@ -3,9 +3,12 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#define FOURP_PIECES 13
-#define TWOP_PIECES 19
+#include "halma_tables.h"
+#ifdef HALMA_NNUE
+#include "halma_nnue.h"
+#endif
 
 #define EXIT_MALLOC_ERROR 39
 
@@ -21,6 +24,211 @@
 // this allocates the exact number of bytes a save file is + 1
 #define SAVE_BUFF_SIZE ((HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT * 2) + 7)
 
+/**
+ * @brief Puts a piece on an empty tile, or clears a tile when piece is EMPTY.
+ * Every change to the board goes through here so the occupied set stays in
+ * sync with the per set pieces.
+ */
+static void halma_set_square(struct halma_board* board, int square,
+                             enum halma_piece piece) {
+  for (int i = 0; i < HALMA_MAX_PLAYERS; i++)
+    bitboard_clearbit(&board->pieces[i], square);
+  bitboard_clearbit(&board->occupied, square);
+#ifdef HALMA_MAILBOX
+  board->mailbox[halma_mailbox_cell(square)] = piece;
+#endif
+  if (piece == EMPTY) return;
+  bitboard_setbit(&board->pieces[halma_set_index(piece)], square);
+  bitboard_setbit(&board->occupied, square);
+}
+
+/**
+ * @brief Looks up which set a square belongs to in a list of per set
+ * bitboards, EMPTY if it is in none of them.
+ */
+static enum halma_piece halma_set_at(const bitboard_T sets[HALMA_MAX_PLAYERS],
+                                     int square) {
+  for (int i = 0; i < HALMA_MAX_PLAYERS; i++)
+    if (bitboard_getbit(&sets[i], square)) return i + 1;
+  return EMPTY;
+}
+
+/**
+ * @brief Counts the goal contents of every set from scratch, for when a board
+ * has just been set up. After that halma_move_piece keeps them updated.
+ */
+static void halma_count_goals(struct halma_board* board) {
+  for (int i = 0; i < HALMA_MAX_PLAYERS; i++) {
+    bitboard_T goal = halma_goal_sets[halma_variant(board)][i];
+    board->goal_own[i] =
+        bitboard_popcount(bitboard_and(goal, board->pieces[i]));
+    board->goal_foreign[i] =
+        bitboard_popcount(bitboard_and(goal, board->occupied)) -
+        board->goal_own[i];
+    board->goal_empty[i] =
+        bitboard_popcount(bitboard_andnot(goal, board->occupied));
+  }
+}
+
+/**
+ * @brief Works out the evaluation sums of every set from scratch, for when a
+ * board has just been set up. After that halma_move_piece keeps them updated.
+ */
+static void halma_sum_distances(struct halma_board* board) {
+  for (int i = 0; i < HALMA_MAX_PLAYERS; i++) {
+    const unsigned char* distances =
+        halma_goal_distances[halma_variant(board)][i];
+    bitboard_T pieces = board->pieces[i];
+    board->distance[i] = board->distance_squared[i] = 0;
+    while (bitboard_any(pieces)) {
+      int distance = distances[bitboard_pop_first(&pieces)];
+      board->distance[i] += distance;
+      board->distance_squared[i] += distance * distance;
+    }
+    board->at_home[i] = bitboard_popcount(bitboard_and(
+        halma_camp_sets[halma_variant(board)][i], board->pieces[i]));
+  }
+}
+
+/**
+ * @brief Builds every set's piece list and the tile to list entry index from
+ * scratch, going through the board row by row. After that halma_move_piece
+ * keeps them updated.
+ */
+static void halma_index_pieces(struct halma_board* board) {
+  for (int i = 0; i < HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT; i++)
+    board->piece_index[i] = -1;
+  for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+    bitboard_T pieces = board->pieces[set];
+    dimension_T count = 0;
+    while (bitboard_any(pieces) && count < HALMA_MAX_PIECES) {
+      int square = bitboard_pop_first(&pieces);
+      board->piece_list[set][count] = square;
+      board->piece_index[square] = count++;
+    }
+  }
+}
+
+/**
+ * @brief Moves the piece belonging to set on from to the empty tile to,
+ * keeping the tile sets and piece list in step. Goal counts are left alone.
+ */
+static void halma_relocate_piece(struct halma_board* board,
+                                 enum halma_piece set, int from, int to) {
+  halma_set_square(board, to, set);
+  halma_set_square(board, from, EMPTY);
+  board->piece_list[halma_set_index(set)][board->piece_index[from]] = to;
+  board->piece_index[to] = board->piece_index[from];
+  board->piece_index[from] = -1;
+}
+
+/**
+ * @brief Moves the piece on from to the empty tile to, keeping the goal counts
+ * and evaluation sums in step. Only the goals containing one of the two tiles
+ * are touched.
+ */
+static void halma_move_piece(struct halma_board* board, int from, int to) {
+  enum halma_piece set = halma_set_at(board->pieces, from);
+  halma_relocate_piece(board, set, from, to);
+  board->hash ^= halma_zobrist_pieces[halma_set_index(set)][from] ^
+                 halma_zobrist_pieces[halma_set_index(set)][to];
+#ifdef HALMA_NNUE
+  halma_nnue_move(board, set, from, to);
+#endif
+
+  dimension_T index = halma_set_index(set);
+  const unsigned char* distances =
+      halma_goal_distances[halma_variant(board)][index];
+  const bitboard_T* home = &halma_camp_sets[halma_variant(board)][index];
+  board->distance[index] += distances[to] - distances[from];
+  board->distance_squared[index] +=
+      (distances[to] * distances[to]) - (distances[from] * distances[from]);
+  board->at_home[index] +=
+      bitboard_getbit(home, to) - bitboard_getbit(home, from);
+
+  const bitboard_T* goals = halma_goal_sets[halma_variant(board)];
+  for (int i = 0; i < board->players; i++) {
+    if (bitboard_getbit(&goals[i], from)) {
+      if (i == halma_set_index(set))
+        board->goal_own[i]--;
+      else
+        board->goal_foreign[i]--;
+      board->goal_empty[i]++;
+    }
+    if (bitboard_getbit(&goals[i], to)) {
+      if (i == halma_set_index(set))
+        board->goal_own[i]++;
+      else
+        board->goal_foreign[i]++;
+      board->goal_empty[i]--;
+    }
+  }
+}
+
+/**
+ * @brief Works the hash out from scratch, for when a board has just been set
+ * up. After that every move updates it.
+ */
+static void halma_hash_board(struct halma_board* board) {
+  board->hash = halma_zobrist_turn[halma_set_index(halma_whos_turn(board))];
+  for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+    bitboard_T pieces = board->pieces[set];
+    while (bitboard_any(pieces))
+      board->hash ^= halma_zobrist_pieces[set][bitboard_pop_first(&pieces)];
+  }
+}
+
+/**
+ * @brief Hands the turn to the next player, keeping the hash in step.
+ * @return dimension_T 0 on success, -2 if turns overflow.
+ */
+static dimension_T halma_next_turn(struct halma_board* board) {
+  if (board->turns == SHRT_MAX) return -2;
+  board->hash ^= halma_zobrist_turn[halma_set_index(halma_whos_turn(board))];
+  board->turns++;
+  board->hash ^= halma_zobrist_turn[halma_set_index(halma_whos_turn(board))];
+  return 0;
+}
+
+static void halma_clear_board(struct halma_board* board) {
+  for (int i = 0; i < HALMA_MAX_PLAYERS; i++) {
+    board->pieces[i] = bitboard_empty();
+  }
+  board->occupied = bitboard_empty();
+#ifdef HALMA_MAILBOX
+  // everything starts off board, then the board itself is cleared out
+  memset(board->mailbox, HALMA_OFF_BOARD, HALMA_MAILBOX_SIZE);
+  for (int i = 0; i < HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT; i++)
+    board->mailbox[halma_mailbox_cell(i)] = EMPTY;
+#endif
+}
+
+enum halma_piece halma_get_piece(struct halma_board* board,
+                                 dimension_T y_index, dimension_T x_index) {
+  int square = halma_square(y_index, x_index);
+  if (!bitboard_getbit(&board->occupied, square)) return EMPTY;
+  return halma_set_at(board->pieces, square);
+}
+
+dimension_T halma_piece_index(struct halma_board* board, dimension_T y_index,
+                              dimension_T x_index) {
+  return board->piece_index[halma_square(y_index, x_index)];
+}
+
+void halma_board_view(struct halma_board* board,
+                      enum halma_piece grid[HALMA_SQUARE_ROOT]
+                                           [HALMA_SQUARE_ROOT]) {
+  for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++)
+    for (dimension_T o = 0; o < HALMA_SQUARE_ROOT; o++) grid[i][o] = EMPTY;
+  for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+    bitboard_T pieces = board->pieces[set];
+    while (bitboard_any(pieces)) {
+      int square = bitboard_pop_first(&pieces);
+      grid[halma_square_y(square)][halma_square_x(square)] = set + 1;
+    }
+  }
+}
+
 struct halma_board* halma_load_game(const char* filename) {
   FILE* savegame = fopen(filename, "rb");
   if (savegame == NULL) return NULL;
@@ -28,8 +236,11 @@ struct halma_board* halma_load_game(const char* filename) {
   struct halma_board* board = malloc(sizeof(struct halma_board));
   check_malloc(board);
 
-  fgets(save_buffer, SAVE_BUFF_SIZE, savegame);
+  // fread instead of fgets, a newline byte in the turn count would otherwise
+  // cut the file short
+  size_t save_size = fread(save_buffer, 1, SAVE_BUFF_SIZE, savegame);
   fclose(savegame);
+  if (save_size != SAVE_BUFF_SIZE - 1) bad_file_break(board);
   // the whole file should now be in memory, these save games aren't that big.
 
   // the file is just a binary lump of the data, we validate the first byte to
@@ -39,20 +250,28 @@ struct halma_board* halma_load_game(const char* filename) {
   if (save_buffer[0] != HALMA_SQUARE_ROOT) bad_file_break(board);
   if (save_buffer[1] != 2 && save_buffer[1] != 4) bad_file_break(board);
 
+  if (save_buffer[2] < 1 || save_buffer[2] > HALMA_MAX_PIECES)
+    bad_file_break(board);
+
   board->players = save_buffer[1];
   board->player_pieces = save_buffer[2];
+  halma_clear_board(board);
 
   // set char* to the beginning of the board in our array
   // row/col and endianness should be fine as this should all be single bytes
   char* save_board = &save_buffer[3];
-  for (int i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (int o = 0; o < HALMA_SQUARE_ROOT; o++)
-      board->grid[i][o] = save_board[(i * HALMA_SQUARE_ROOT) + o];
+  for (int i = 0; i < HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT; i++) {
+    if (save_board[i] < EMPTY || save_board[i] > GREEN) bad_file_break(board);
+    halma_set_square(board, i, save_board[i]);
+  }
 
   save_board += (HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT);
-  for (int i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (int o = 0; o < HALMA_SQUARE_ROOT; o++)
-      board->victory_mask[i][o] = save_board[(i * HALMA_SQUARE_ROOT) + o];
+  // goals come from the lookup tables now, but they still have to agree with
+  // the file
+  for (int i = 0; i < HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT; i++)
+    if (save_board[i] !=
+        halma_set_at(halma_goal_sets[halma_variant(board)], i))
+      bad_file_break(board);
 
   save_board += (HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT);
   short turns_divisor = save_board[0];  // just going to take it from the file,
@@ -60,6 +279,20 @@ struct halma_board* halma_load_game(const char* filename) {
   board->turns = save_board[1] * turns_divisor;
   board->turns += save_board[2];
 
+  // every set in the game needs exactly as many pieces as the file says
+  for (int i = 0; i < HALMA_MAX_PLAYERS; i++)
+    if (bitboard_popcount(board->pieces[i]) !=
+        (i < board->players ? board->player_pieces : 0))
+      bad_file_break(board);
+
+  halma_count_goals(board);
+  halma_sum_distances(board);
+#ifdef HALMA_NNUE
+  halma_nnue_refresh(board);
+#endif
+  halma_index_pieces(board);
+  halma_hash_board(board);
+
   return board;
 }
 
@@ -70,12 +303,11 @@ int halma_save_game(const char* filename, struct halma_board* board) {
   putc(board->players, savegame);
   putc(board->player_pieces, savegame);
 
-  for (int i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (int o = 0; o < HALMA_SQUARE_ROOT; o++)
-      putc(board->grid[i][o], savegame);
-  for (int i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (int o = 0; o < HALMA_SQUARE_ROOT; o++)
-      putc(board->victory_mask[i][o], savegame);
+  // the file format predates the bitboards, so write it out a tile at a time
+  for (int i = 0; i < HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT; i++)
+    putc(halma_set_at(board->pieces, i), savegame);
+  for (int i = 0; i < HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT; i++)
+    putc(halma_set_at(halma_goal_sets[halma_variant(board)], i), savegame);
 
   // number of turns goes at the end, because its the only value greater than a
   // single byte we need to handle
@@ -95,17 +327,16 @@ dimension_T halma_validate_piece_selection(struct halma_board* board,
                                            struct halma_moves* moves,
                                            enum halma_piece turn) {
   // there isn't one of our pieces here, return 1
-  if (board->grid[y_index][x_index] != turn) return -1;
+  if (!bitboard_getbit(&board->pieces[halma_set_index(turn)],
+                       halma_square(y_index, x_index)))
+    return -1;
 
   // locate this piece in the move table
-  dimension_T i;
-  for (i = 0; i < board->player_pieces; i++) {
-    if (moves[i].origin_y == y_index && moves[i].origin_x == x_index) break;
-  }
+  dimension_T i = halma_piece_index(board, y_index, x_index);
 
   // there was no move table located for this piece, somethings gone wrong,
   // return -2
-  if (i == board->player_pieces) return -2;
+  if (moves[i].origin_y != y_index || moves[i].origin_x != x_index) return -2;
 
   // this piece can't move anywhere, return 3
   if (!anybit(moves[i].targets)) return -3;
@@ -124,27 +355,112 @@ dimension_T halma_accept_move(struct halma_board* board,
                               struct halma_moves* move, dimension_T y_index,
                               dimension_T x_index) {
   if(!halma_validate_target_selection(move, y_index, x_index)) return -1;
-  board->grid[y_index][x_index] = board->grid[move->origin_y][move->origin_x];
-  board->grid[move->origin_y][move->origin_x] = EMPTY;
-  if(board->turns == SHRT_MAX) return -2;
-  board->turns++;
+  halma_move_piece(board, halma_square(move->origin_y, move->origin_x),
+                   halma_square(y_index, x_index));
+  return halma_next_turn(board);
+}
+
+bool halma_is_legal_move(struct halma_board* board, int from, int to) {
+  const int cells = HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT;
+  if (from < 0 || from >= cells || to < 0 || to >= cells) return false;
+  enum halma_piece set = halma_whos_turn(board);
+  if (!bitboard_getbit(&board->pieces[halma_set_index(set)], from) ||
+      bitboard_getbit(&board->occupied, to))
+    return false;
+  // a piece in its goal has to stay in it
+  bitboard_T goal = halma_goal(board, set);
+  if (bitboard_getbit(&goal, from) && !bitboard_getbit(&goal, to))
+    return false;
+  if (bitboard_getbit(&halma_neighbor_sets[from], to)) return true;
+
+  // depth first through the jump tables, every tile gets pushed at most once
+  unsigned char stack[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+  bitboard_T seen = bitboard_empty();
+  int top = 0;
+  bitboard_setbit(&seen, from);
+  stack[top++] = from;
+  while (top > 0) {
+    int square = stack[--top];
+    for (int i = 0; i < halma_jump_counts[square]; i++) {
+      const struct halma_jump* jump = &halma_jumps[square][i];
+      if (!bitboard_getbit(&board->occupied, jump->over) ||
+          bitboard_getbit(&board->occupied, jump->landing) ||
+          bitboard_getbit(&seen, jump->landing))
+        continue;
+      if (jump->landing == to) return true;
+      bitboard_setbit(&seen, jump->landing);
+      stack[top++] = jump->landing;
+    }
+  }
+  return false;
+}
+
+void halma_init_undo(struct halma_undo_stack* stack, struct halma_undo* records,
+                     int capacity) {
+  stack->records = records;
+  stack->top = 0;
+  stack->capacity = capacity;
+}
+
+dimension_T halma_make_move(struct halma_board* board,
+                            struct halma_undo_stack* stack, int from, int to) {
+  if (stack->top == stack->capacity) return -1;
+  if (board->turns == SHRT_MAX) return -2;
+  struct halma_undo* record = &stack->records[stack->top++];
+  record->from = from;
+  record->to = to;
+  record->turns = board->turns;
+  record->hash = board->hash;
+  memcpy(record->goal_own, board->goal_own, sizeof(board->goal_own));
+  memcpy(record->goal_foreign, board->goal_foreign,
+         sizeof(board->goal_foreign));
+  memcpy(record->goal_empty, board->goal_empty, sizeof(board->goal_empty));
+  memcpy(record->distance, board->distance, sizeof(board->distance));
+  memcpy(record->distance_squared, board->distance_squared,
+         sizeof(board->distance_squared));
+  memcpy(record->at_home, board->at_home, sizeof(board->at_home));
+  if (from != to) halma_move_piece(board, from, to);
+  halma_next_turn(board);
+  return 0;
+}
+
+dimension_T halma_unmake_move(struct halma_board* board,
+                              struct halma_undo_stack* stack) {
+  if (stack->top == 0) return -1;
+  struct halma_undo* record = &stack->records[--stack->top];
+  // the counters come straight from the record, no need to work them out
+  // again going backwards
+  if (record->from != record->to) {
+    enum halma_piece set = halma_set_at(board->pieces, record->to);
+    halma_relocate_piece(board, set, record->to, record->from);
+#ifdef HALMA_NNUE
+    // too big to keep a copy of in every record, moving back is cheap anyway
+    halma_nnue_move(board, set, record->to, record->from);
+#endif
+  }
+  board->turns = record->turns;
+  board->hash = record->hash;
+  memcpy(board->goal_own, record->goal_own, sizeof(board->goal_own));
+  memcpy(board->goal_foreign, record->goal_foreign,
+         sizeof(board->goal_foreign));
+  memcpy(board->goal_empty, record->goal_empty, sizeof(board->goal_empty));
+  memcpy(board->distance, record->distance, sizeof(board->distance));
+  memcpy(board->distance_squared, record->distance_squared,
+         sizeof(board->distance_squared));
+  memcpy(board->at_home, record->at_home, sizeof(board->at_home));
   return 0;
 }
 
+dimension_T halma_pass_turn(struct halma_board* board) {
+  return halma_next_turn(board);
+}
+
 bool halma_check_victory(struct halma_board* board, enum halma_piece turn) {
-  dimension_T player_pieces = 0;
-  dimension_T nonplayer_pieces = 0;
-  for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (dimension_T o = 0; o < HALMA_SQUARE_ROOT; o++)
-      if (board->victory_mask[i][o] == turn) {
-        if (board->grid[i][o] == EMPTY) return false;
-        if (board->grid[i][o] == turn)
-          player_pieces++;
-        else
-          nonplayer_pieces++;
-      }
-  if (player_pieces > 0 &&
-      (player_pieces + nonplayer_pieces) == board->player_pieces)
+  dimension_T i = halma_set_index(turn);
+  // any empty tile in the goal means nobody can have filled it yet
+  if (board->goal_empty[i] > 0) return false;
+  if (board->goal_own[i] > 0 &&
+      (board->goal_own[i] + board->goal_foreign[i]) == board->player_pieces)
     return true;
   return false;
 }
@@ -153,7 +469,6 @@ bool halma_any_possible_moves(struct halma_board* board, struct halma_moves* mov
   for(dimension_T i = 0; i < board->player_pieces; i++)
     if(anybit(moves[i].targets))
       return true;
-  board->turns++;
   return false;
 }
 
@@ -167,245 +482,427 @@ enum halma_piece halma_check_victory_all(struct halma_board* board) {
   return EMPTY;
 }
 
+enum halma_piece halma_play_move(struct halma_board* board, int from, int to) {
+  halma_next_turn(board);
+  if (from == to) return EMPTY;
+  halma_move_piece(board, from, to);
+  // a goal can only have just been filled if the piece landed in it
+  const bitboard_T* goals = halma_goal_sets[halma_variant(board)];
+  for (int i = 0; i < board->players; i++)
+    if (bitboard_getbit(&goals[i], to) && halma_check_victory(board, i + 1))
+      return i + 1;
+  return EMPTY;
+}
+
 enum halma_piece halma_whos_turn(struct halma_board* board){
   return (board->turns % board->players) + 1;
 }
 
+// the eight directions a piece can step or jump in, as (dy, dx) pairs
+static const dimension_T halma_directions[8][2] = {
+    {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
 /**
- * @brief Gets at max a 3x3 section of coordiantes centered on orig_y and orig_x
- * Will check the bounds and truncate if needed.
+ * @brief Finds every tile reachable from the tiles in start by one or more
+ * jumps. Works on whole sets at once: each round jumps the current frontier in
+ * all eight directions, keeps what landed on new empty tiles and repeats until
+ * no new tiles turn up. The starting tiles stay occupied, same as during a
+ * real move, so a piece can jump back over its own origin.
+ *
+ * @param occupied every occupied tile on the board.
+ * @param start tiles to start jumping from.
+ * @return bitboard_T every tile that can be landed on.
  */
-#define halma_get_3x3_bounds(top_y, top_x, bot_y, bot_x, orig_y, orig_x) \
-  top_y = orig_y - 1;                                                    \
-  if (top_y < 0) top_y = 0;                                              \
-  top_x = orig_x - 1;                                                    \
-  if (top_x < 0) top_x = 0;                                              \
-  bot_y = orig_y + 2;                                                    \
-  if (bot_y >= HALMA_SQUARE_ROOT) bot_y = HALMA_SQUARE_ROOT;             \
-  bot_x = orig_x + 2;                                                    \
-  if (bot_x >= HALMA_SQUARE_ROOT) bot_x = HALMA_SQUARE_ROOT;
-
-void halma_search_jump(struct halma_board* board, struct halma_moves* move,
-                       dimension_T piece_y, dimension_T piece_x,
-                       dimension_T origin_y, dimension_T origin_x) {
-  dimension_T difference_y = piece_y + (piece_y - origin_y);
-  dimension_T difference_x = piece_x + (piece_x - origin_x);
-
-  // of the edge of the board, no more searches, I don't actually know if all of
-  // these are possible to encounter
-  if (difference_y < 0) return;
-  if (difference_y >= HALMA_SQUARE_ROOT) return;
-  if (difference_x < 0) return;
-  if (difference_x >= HALMA_SQUARE_ROOT) return;
-
-  if (board->grid[difference_y][difference_x] == EMPTY) {
-    // mark this tile as movalbe to, if this tile
-    // has already been marked as a good move, return.
-    if (getsetbit(move->targets, difference_y, difference_x)) return;
-
-    // search the area around this tile for other jumpable pieces
-    dimension_T top_y, top_x, bot_y, bot_x;
-    halma_get_3x3_bounds(top_y, top_x, bot_y, bot_x, difference_y,
-                         difference_x);
-    for (int i = top_y; i < bot_y; i++)
-      for (int o = top_x; o < bot_x; o++)
-        if (board->grid[i][o] != EMPTY)
-          halma_search_jump(board, move, i, o, difference_y, difference_x);
+bitboard_T halma_search_jumps(bitboard_T occupied, bitboard_T start) {
+  bitboard_T visited = bitboard_empty();
+  bitboard_T frontier = start;
+  do {
+    bitboard_T landed = bitboard_empty();
+    for (int i = 0; i < 8; i++) {
+      dimension_T dy = halma_directions[i][0];
+      dimension_T dx = halma_directions[i][1];
+      bitboard_T over = bitboard_and(bitboard_step(frontier, dy, dx), occupied);
+      landed = bitboard_or(
+          landed, bitboard_andnot(bitboard_step(over, dy, dx), occupied));
+    }
+    frontier = bitboard_andnot(landed, visited);
+    visited = bitboard_or(visited, frontier);
+  } while (bitboard_any(frontier));
+  return visited;
+}
+
+/**
+ * @brief Every tile whose contents a jump search looked at, given the tiles it
+ * jumped from (including the origin). Each of those checked its neighbors to
+ * jump over and the tiles past them to land on. If none of these tiles change
+ * the search would come out the same.
+ */
+bitboard_T halma_search_influence(bitboard_T jumped_from) {
+  bitboard_T influence = bitboard_empty();
+  while (bitboard_any(jumped_from)) {
+    int square = bitboard_pop_first(&jumped_from);
+    influence = bitboard_or(influence, bitboard_or(halma_neighbor_sets[square],
+                                                   halma_landing_sets[square]));
   }
+  return influence;
 }
 
-void halma_search_immediate(struct halma_board* board,
-                            struct halma_moves* move) {
-  dimension_T top_y, top_x, bot_y, bot_x;
-  halma_get_3x3_bounds(top_y, top_x, bot_y, bot_x, move->origin_y,
-                       move->origin_x);
-  for (int i = top_y; i < bot_y; i++)
-    for (int o = top_x; o < bot_x; o++)
-      // immediate movements
-      if (board->grid[i][o] == EMPTY) setbit(move->targets, i, o);
-      // jump movements, only allowed to jump if we are NOT in the victory
-      // location
-      else
-        halma_search_jump(board, move, i, o, move->origin_y, move->origin_x);
+/**
+ * @brief Every tile a piece on square can move to, steps to empty neighbors
+ * plus everything it can reach by jumping. Doesn't apply the victory area rule.
+ *
+ * @param occupied every occupied tile on the board.
+ * @param square the tile the piece is on.
+ * @param influence if not NULL, set to every tile whose contents were looked
+ * at. If none of those tiles change the targets won't either.
+ * @return bitboard_T the tiles the piece can move to.
+ */
+bitboard_T halma_search_immediate(bitboard_T occupied, int square,
+                                  bitboard_T* influence) {
+  bitboard_T origin = bitboard_empty();
+  bitboard_setbit(&origin, square);
+  bitboard_T jumps = halma_search_jumps(occupied, origin);
+  bitboard_T steps = halma_neighbor_sets[square];
+
+  if (influence != NULL)
+    *influence = halma_search_influence(bitboard_or(jumps, origin));
+
+  return bitboard_or(bitboard_andnot(steps, occupied), jumps);
 }
 
-void halma_cull_victory_moves(struct halma_board* board,
-                              struct halma_moves* move) {
-  if (!anybit(move->targets))
-    return;  // no valid moves, we don't need to check anything
+#ifdef HALMA_MAILBOX
+// neighbor offsets in the mailbox, the ring of off board tiles around it means
+// these work for every tile on the board without checking the edges
+static const int halma_mailbox_offsets[8] = {
+    -HALMA_MAILBOX_STRIDE - 1, -HALMA_MAILBOX_STRIDE, -HALMA_MAILBOX_STRIDE + 1,
+    -1,                        1,                     HALMA_MAILBOX_STRIDE - 1,
+    HALMA_MAILBOX_STRIDE,      HALMA_MAILBOX_STRIDE + 1};
 
-  enum halma_piece turn = board->grid[move->origin_y][move->origin_x];
-  // part of my goal when making this game was to never have to hammer through
-  // an entire bitmask for anything, after some experimentation this was the
-  // best I could do. Might be something to revisit down the line.
-  for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (dimension_T o = 0; o < HALMA_SQUARE_ROOT; o++)
-      if (board->victory_mask[i][o] != turn)
-        if (getbit(move->targets, i, o)) togglebit(move->targets, i, o);
+#define halma_mailbox_to_square(cell)                            \
+  halma_square(((cell) / HALMA_MAILBOX_STRIDE) - HALMA_MAILBOX_RING, \
+               ((cell) % HALMA_MAILBOX_STRIDE) - HALMA_MAILBOX_RING)
+
+/**
+ * @brief Same as halma_search_immediate but run over the mailbox grid. The
+ * jump search keeps its own stack of tiles to jump from, and the ring is two
+ * tiles wide so both the tile jumped over and the tile landed on can be read
+ * without checking anything first. Whether to push a landing tile is worked
+ * out arithmetically rather than with a branch, and the tiles already reached
+ * are kept on a bitboard by board square, which is also the jump targets once
+ * the origin is taken out.
+ */
+bitboard_T halma_mailbox_search_immediate(const unsigned char* mailbox,
+                                          int square, bitboard_T* influence) {
+  // every tile gets pushed at most once, plus room for the unconditional write
+  int stack[(HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT) + 1];
+  int top = 0;
+  bitboard_T jumps = bitboard_empty();
+  bitboard_T steps = bitboard_empty();
+  int origin = halma_mailbox_cell(square);
+
+  for (int i = 0; i < 8; i++) {
+    int neighbor = origin + halma_mailbox_offsets[i];
+    if (mailbox[neighbor] == EMPTY)
+      bitboard_setbit(&steps, halma_mailbox_to_square(neighbor));
+  }
+
+  bitboard_setbit(&jumps, square);
+  stack[top++] = origin;
+  while (top > 0) {
+    int cell = stack[--top];
+    for (int i = 0; i < 8; i++) {
+      int over = cell + halma_mailbox_offsets[i];
+      int landing = over + halma_mailbox_offsets[i];
+      // pieces are 1 through 4, so this is false for EMPTY and off board
+      int jumpable = (unsigned char)(mailbox[over] - 1) < GREEN;
+      int open = mailbox[landing] == EMPTY;
+      // off board landings are looked up as square 0, open masks them out
+      int reached = halma_mailbox_to_square(landing) * open;
+      uint64_t push = jumpable & open & !bitboard_getbit(&jumps, reached);
+      jumps.words[reached >> 6] |= push << (reached & 63);
+      stack[top] = landing;
+      top += push;
+    }
+  }
+  bitboard_clearbit(&jumps, square);
+
+  if (influence != NULL) {
+    bitboard_T jumped_from = jumps;
+    bitboard_setbit(&jumped_from, square);
+    *influence = halma_search_influence(jumped_from);
+  }
+
+  return bitboard_or(steps, jumps);
 }
+#endif
 
-struct halma_moves* halma_gather_valid_moves(struct halma_board* board,
-                                             enum halma_piece set) {
-  struct halma_moves* moves_table =
-      malloc(sizeof(struct halma_moves) * board->player_pieces);
-  check_malloc(moves_table);
-  dimension_T pieces_count = 0;
-  for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (dimension_T o = 0; o < HALMA_SQUARE_ROOT; o++)
-      if (board->grid[i][o] == set) {
-        moves_table[pieces_count].targets =
-            create_bitmask(HALMA_SQUARE_ROOT, HALMA_SQUARE_ROOT);
-        moves_table[pieces_count].origin_y = i;
-        moves_table[pieces_count].origin_x = o;
-
-        halma_search_immediate(board, &moves_table[pieces_count]);
-
-        // if we are inside of the victory area make sure we can't move outside
-        // of it intermediate jumps outside are fine but if it started in the
-        // victory area it needs to end in the victory area
-        if ((board->grid[i][o] == board->victory_mask[i][o]))
-          halma_cull_victory_moves(board, &moves_table[pieces_count]);
-
-        pieces_count++;
+// bitboards and bitmasks lay out their bits the same way, a board sized mask
+// can be loaded straight from a bitboard's words
+_Static_assert(BITMASK_BLOCKS(HALMA_SQUARE_ROOT, HALMA_SQUARE_ROOT) ==
+                   BITBOARD_WORDS,
+               "bitmask and bitboard layouts differ");
+
+/**
+ * @brief Copies a set of targets built on a bitboard into the move's bitmask.
+ */
+void halma_store_targets(struct halma_moves* move, bitboard_T targets) {
+  load_bitmask(move->targets, targets.words);
+}
+
+bitboard_T halma_piece_targets(struct halma_board* board, enum halma_piece set,
+                               int square, bitboard_T* influence) {
+  bitboard_T goal = halma_goal(board, set);
+#ifdef HALMA_MAILBOX
+  bitboard_T targets =
+      halma_mailbox_search_immediate(board->mailbox, square, influence);
+#else
+  bitboard_T targets =
+      halma_search_immediate(board->occupied, square, influence);
+#endif
+
+  // if we are inside of the victory area make sure we can't move outside
+  // of it intermediate jumps outside are fine but if it started in the
+  // victory area it needs to end in the victory area
+  if (bitboard_getbit(&goal, square)) targets = bitboard_and(targets, goal);
+  return targets;
+}
+
+/**
+ * @brief Fills in a move table entry for the piece on square, the entry's
+ * bitmask needs to already be allocated and empty.
+ */
+void halma_fill_move(struct halma_board* board, struct halma_moves* move,
+                     int square) {
+  enum halma_piece set =
+      halma_get_piece(board, halma_square_y(square), halma_square_x(square));
+  move->origin_y = halma_square_y(square);
+  move->origin_x = halma_square_x(square);
+  halma_store_targets(
+      move, halma_piece_targets(board, set, square, &move->influence));
+}
+
+struct halma_moves* halma_gather_moves_into(struct halma_board* board,
+                                            enum halma_piece set,
+                                            struct halma_moves_arena* arena) {
+  for (dimension_T i = 0; i < board->player_pieces; i++) {
+    arena->moves[i].targets = &arena->masks[i];
+    init_bitmask(&arena->masks[i], arena->storage[i], HALMA_SQUARE_ROOT,
+                 HALMA_SQUARE_ROOT);
+    halma_fill_move(board, &arena->moves[i],
+                    board->piece_list[halma_set_index(set)][i]);
+  }
+
+  return arena->moves;
+}
+
+int halma_generate_moves(struct halma_board* board, enum halma_piece set,
+                         halma_move_T moves[HALMA_MAX_MOVES]) {
+  int count = 0;
+  for (dimension_T i = 0; i < board->player_pieces; i++) {
+    int from = board->piece_list[halma_set_index(set)][i];
+    bitboard_T targets = halma_piece_targets(board, set, from, NULL);
+    while (bitboard_any(targets))
+      moves[count++] = halma_move(from, bitboard_pop_first(&targets));
+  }
+  return count;
+}
+
+/**
+ * @brief Jump groups for halma_count_mobility: empty tiles linked by jumps
+ * over occupied tiles. The links are the same whichever piece is jumping, so
+ * a piece whose first jump lands in a group can get to every tile of it.
+ * Groups are only worked out once a piece lands in them.
+ */
+struct jump_groups {
+  bitboard_T labeled;  // tiles already in a group
+  short group_of[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];  // where labeled
+  short size[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+  short goal_tiles[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT][HALMA_MAX_PLAYERS];
+  int count;
+};
+
+/**
+ * @brief Finds the group of an empty tile, working it out if no piece has
+ * landed in it yet. Most groups are a tile or two, so they are walked through
+ * the jump tables rather than flooded over the whole board.
+ */
+static int jump_group(struct halma_board* board, struct jump_groups* groups,
+                      int square) {
+  if (bitboard_getbit(&groups->labeled, square))
+    return groups->group_of[square];
+
+  int group = groups->count++;
+  int stack[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+  int top = 0;
+  bitboard_T tiles = bitboard_empty();
+  bitboard_setbit(&groups->labeled, square);
+  stack[top++] = square;
+  while (top > 0) {
+    int tile = stack[--top];
+    groups->group_of[tile] = group;
+    bitboard_setbit(&tiles, tile);
+    for (int i = 0; i < halma_jump_counts[tile]; i++) {
+      const struct halma_jump* jump = &halma_jumps[tile][i];
+      if (bitboard_getbit(&board->occupied, jump->over) &&
+          !bitboard_getbit(&board->occupied, jump->landing) &&
+          !bitboard_getbit(&groups->labeled, jump->landing)) {
+        bitboard_setbit(&groups->labeled, jump->landing);
+        stack[top++] = jump->landing;
       }
+    }
+  }
 
-  return moves_table;
+  groups->size[group] = bitboard_popcount(tiles);
+  for (int set = 0; set < board->players; set++)
+    groups->goal_tiles[group][set] = bitboard_popcount(
+        bitboard_and(tiles, halma_goal_sets[halma_variant(board)][set]));
+  return group;
 }
 
-void halma_gen_victory_mask(struct halma_board* board) {
-  // loop through the board swapping each color for whats on the opposite corner
-  for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (dimension_T o = 0; o < HALMA_SQUARE_ROOT; o++)
-      switch (board->grid[i][o]) {
-        case RED:
-          board->victory_mask[i][o] = YELLOW;
-          break;
-        case GREEN:
-          board->victory_mask[i][o] = BLUE;
-          break;
-        case BLUE:
-          board->victory_mask[i][o] = GREEN;
-          break;
-        case YELLOW:
-          board->victory_mask[i][o] = RED;
-          break;
-        default:
-          board->victory_mask[i][o] = EMPTY;
-          break;
+void halma_count_mobility(struct halma_board* board,
+                          struct halma_mobility* mobility) {
+  struct jump_groups groups;
+  groups.labeled = bitboard_empty();
+  groups.count = 0;
+  memset(mobility, 0, sizeof(struct halma_mobility));
+
+  for (int set = 0; set < board->players; set++) {
+    bitboard_T goal = halma_goal_sets[halma_variant(board)][set];
+    for (dimension_T i = 0; i < board->player_pieces; i++) {
+      int square = board->piece_list[set][i];
+      // a piece in its goal can only move to other goal tiles
+      bool in_goal = bitboard_getbit(&goal, square);
+      bitboard_T steps =
+          bitboard_andnot(halma_neighbor_sets[square], board->occupied);
+      if (in_goal) steps = bitboard_and(steps, goal);
+      int count = bitboard_popcount(steps);
+
+      int reached[8];
+      int reached_count = 0;
+      for (int j = 0; j < halma_jump_counts[square]; j++) {
+        const struct halma_jump* jump = &halma_jumps[square][j];
+        if (!bitboard_getbit(&board->occupied, jump->over) ||
+            bitboard_getbit(&board->occupied, jump->landing))
+          continue;
+        int group = jump_group(board, &groups, jump->landing);
+        int k = 0;
+        while (k < reached_count && reached[k] != group) k++;
+        if (k < reached_count) continue;
+        reached[reached_count++] = group;
+        count += in_goal ? groups.goal_tiles[group][set] : groups.size[group];
       }
+
+      // a step to a tile that a jump gets to as well is only one move
+      while (bitboard_any(steps)) {
+        int step = bitboard_pop_first(&steps);
+        if (!bitboard_getbit(&groups.labeled, step)) continue;
+        for (int k = 0; k < reached_count; k++)
+          if (reached[k] == groups.group_of[step]) count--;
+      }
+
+      mobility->pieces[set][i] = count;
+      mobility->sets[set] += count;
+    }
+  }
 }
 
-struct halma_board* halma_init_board_4p() {
-  struct halma_board* board = malloc(sizeof(struct halma_board));
-  check_malloc(board);
-  // set turns to zero
-  board->turns = 0;
+struct halma_moves* halma_gather_valid_moves(struct halma_board* board,
+                                             enum halma_piece set) {
+  struct halma_moves_arena* arena = malloc(sizeof(struct halma_moves_arena));
+  check_malloc(arena);
+  return halma_gather_moves_into(board, set, arena);
+}
 
-  // set number of players
-  board->players = 4;
+void halma_update_moves(struct halma_board* board,
+                        struct halma_moves* moves_table, dimension_T from_y,
+                        dimension_T from_x, dimension_T to_y,
+                        dimension_T to_x) {
+  int from = halma_square(from_y, from_x);
+  int to = halma_square(to_y, to_x);
+  for (dimension_T i = 0; i < board->player_pieces; i++) {
+    struct halma_moves* move = &moves_table[i];
+    int square = halma_square(move->origin_y, move->origin_x);
+    // the piece that moved is the only one whose origin changes
+    if (square == from)
+      square = to;
+    else if (!bitboard_getbit(&move->influence, from) &&
+             !bitboard_getbit(&move->influence, to))
+      continue;
+    reset_bitmask(move->targets);
+    halma_fill_move(board, move, square);
+  }
+}
 
-  // set number of pieces
-  board->player_pieces = FOURP_PIECES;
+void halma_gather_all_moves(struct halma_board* board,
+                            struct halma_all_moves* all_moves) {
+  for (dimension_T i = 0; i < HALMA_MAX_PLAYERS; i++)
+    all_moves->sets[i] =
+        i < board->players ? halma_gather_valid_moves(board, i + 1) : NULL;
+}
 
-  // initialize board to EMPTY
-  for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (dimension_T o = 0; o < HALMA_SQUARE_ROOT; o++)
-      board->grid[i][o] = EMPTY;
-
-  // initialize RED pieces
-  for (dimension_T i = 0; i < (HALMA_SQUARE_ROOT / 4); i++)
-    for (dimension_T o = (HALMA_SQUARE_ROOT / 4) - i; o >= 0; o--)
-      board->grid[i][o] = RED;
-  // algorithm generates one extra tile on row 0
-  // alogrithm would generate extra tile on other end of pieces
-  // if the condition was i < (SQUARE_ROOT / 4) + 1, we skip the last row
-  // because it is all extra. A similar thing happens to all corners.
-  board->grid[0][(HALMA_SQUARE_ROOT / 4)] = EMPTY;
-
-  // initialize GREEN pieces
-  for (dimension_T i = 0; i < (HALMA_SQUARE_ROOT / 4); i++)
-    for (dimension_T o = HALMA_SQUARE_ROOT - 1;
-         o >= HALMA_SQUARE_ROOT - (HALMA_SQUARE_ROOT / 4) + i - 1; o--)
-      board->grid[i][o] = GREEN;
-  // remove extra piece at ends
-  board->grid[0][HALMA_SQUARE_ROOT - (HALMA_SQUARE_ROOT / 4) - 1] = EMPTY;
-
-  // initialize BLUE pieces
-  for (dimension_T i = HALMA_SQUARE_ROOT - 1;
-       i >= HALMA_SQUARE_ROOT - (HALMA_SQUARE_ROOT / 4); i--)
-    for (dimension_T o = 0;
-         o < (HALMA_SQUARE_ROOT / 4) - (HALMA_SQUARE_ROOT - i) + 2; o++)
-      board->grid[i][o] = BLUE;
-  // remove extra piece at end
-  board->grid[HALMA_SQUARE_ROOT - 1][HALMA_SQUARE_ROOT / 4] = EMPTY;
-
-  // intialize YELLOW pieces
-  for (dimension_T i = HALMA_SQUARE_ROOT - 1;
-       i >= HALMA_SQUARE_ROOT - (HALMA_SQUARE_ROOT / 4); i--)
-    for (dimension_T o = HALMA_SQUARE_ROOT - 1;
-         o >= HALMA_SQUARE_ROOT - (HALMA_SQUARE_ROOT / 4) - 1 +
-                  (HALMA_SQUARE_ROOT - i - 1);
-         o--)
-      board->grid[i][o] = YELLOW;
-  // remove extra pieces at end
-  board->grid[HALMA_SQUARE_ROOT - 1]
-             [HALMA_SQUARE_ROOT - 1 - (HALMA_SQUARE_ROOT / 4)] = EMPTY;
-
-  // initialize the victory mask
-  halma_gen_victory_mask(board);
+void halma_update_all_moves(struct halma_board* board,
+                            struct halma_all_moves* all_moves,
+                            dimension_T from_y, dimension_T from_x,
+                            dimension_T to_y, dimension_T to_x) {
+  for (dimension_T i = 0; i < board->players; i++)
+    halma_update_moves(board, all_moves->sets[i], from_y, from_x, to_y, to_x);
+}
 
-  return board;
+void halma_clear_all_moves(struct halma_board* board,
+                           struct halma_all_moves* all_moves) {
+  for (dimension_T i = 0; i < HALMA_MAX_PLAYERS; i++) {
+    if (all_moves->sets[i] != NULL)
+      halma_clear_moves(board, all_moves->sets[i]);
+    all_moves->sets[i] = NULL;
+  }
 }
 
-struct halma_board* halma_init_board_2p() {
+/**
+ * @brief Allocates a board and sets the pieces up for a variant, straight from
+ * the camp tables.
+ */
+static struct halma_board* halma_init_board(enum halma_variant variant,
+                                            dimension_T players) {
   struct halma_board* board = malloc(sizeof(struct halma_board));
   check_malloc(board);
   // set turns to zero
   board->turns = 0;
 
-  // set number of players
-  board->players = 2;
+  // set number of players and pieces
+  board->players = players;
+  board->player_pieces = halma_variant_pieces[variant];
 
-  // set number of pieces
-  board->player_pieces = TWOP_PIECES;
+  // initialize board to EMPTY, then put every set in its camp
+  halma_clear_board(board);
+  for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+    bitboard_T camp = halma_camp_sets[variant][set];
+    while (bitboard_any(camp))
+      halma_set_square(board, bitboard_pop_first(&camp), set + 1);
+  }
 
-  // initialize board to EMPTY
-  for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++)
-    for (dimension_T o = 0; o < HALMA_SQUARE_ROOT; o++)
-      board->grid[i][o] = EMPTY;
-
-  // initialize RED pieces
-  for (dimension_T i = 0; i < (HALMA_SQUARE_ROOT / 3); i++)
-    for (dimension_T o = (HALMA_SQUARE_ROOT / 3) - i; o >= 0; o--)
-      board->grid[i][o] = RED;
-  // algorithm generates one extra tile on row 0
-  // alogrithm would generate extra tile on other end of pieces
-  // if the condition was i < (SQUARE_ROOT / 4) + 1, we skip the last row
-  // because it is all extra. A similar thing happens to all corners.
-  board->grid[0][(HALMA_SQUARE_ROOT / 3)] = EMPTY;
-
-  // intialize YELLOW pieces
-  for (dimension_T i = HALMA_SQUARE_ROOT - 1;
-       i >= HALMA_SQUARE_ROOT - (HALMA_SQUARE_ROOT / 3); i--)
-    for (dimension_T o = HALMA_SQUARE_ROOT - 1;
-         o >= HALMA_SQUARE_ROOT - (HALMA_SQUARE_ROOT / 3) - 1 +
-                  (HALMA_SQUARE_ROOT - i - 1);
-         o--)
-      board->grid[i][o] = YELLOW;
-  // remove extra pieces at end
-  board->grid[HALMA_SQUARE_ROOT - 1]
-             [HALMA_SQUARE_ROOT - 1 - (HALMA_SQUARE_ROOT / 3)] = EMPTY;
-
-  // initialize the victory mask
-  halma_gen_victory_mask(board);
+  halma_count_goals(board);
+  halma_sum_distances(board);
+#ifdef HALMA_NNUE
+  halma_nnue_refresh(board);
+#endif
+  halma_index_pieces(board);
+  halma_hash_board(board);
 
   return board;
 }
 
+struct halma_board* halma_init_board_4p() {
+  return halma_init_board(HALMA_VARIANT_4P, 4);
+}
+
+struct halma_board* halma_init_board_2p() {
+  return halma_init_board(HALMA_VARIANT_2P, 2);
+}
+
 void halma_clear_moves(struct halma_board* board,
                        struct halma_moves* moves_table) {
-  for (int i = 0; i < board->player_pieces; i++)
-    destroy_bitmask(moves_table[i].targets);
+  // the table is the start of the arena it was gathered into
+  (void)board;
   free(moves_table);
 }
 void halma_end_game(struct halma_board* board) { free(board); }
\ No newline at end of file
@@ -1,8 +1,28 @@
 #ifndef HALMA_H_INCLUDED
 #define HALMA_H_INCLUDED
+// The board size is fixed at build time ('make SIZE=10'), so every table and
+// loop that depends on it gets sized and unrolled for that one size. The camp
+// layouts for each size are in halma_tablegen.c.
+#ifndef HALMA_SQUARE_ROOT
+#define HALMA_SQUARE_ROOT 16
+#endif
+
+// most pieces a single set can have, always a 2 player game
+#if HALMA_SQUARE_ROOT == 16
+#define HALMA_MAX_PIECES 19
+#elif HALMA_SQUARE_ROOT == 10
+#define HALMA_MAX_PIECES 15
+#elif HALMA_SQUARE_ROOT == 8
+#define HALMA_MAX_PIECES 10
+#else
+#error "no board layout for this HALMA_SQUARE_ROOT, use 8, 10 or 16"
+#endif
+
+#define BITBOARD_WIDTH HALMA_SQUARE_ROOT
+#include "bitboard.h"
 #include "bitmask.h"
 
-#define HALMA_SQUARE_ROOT 16
+#define HALMA_MAX_PLAYERS 4
 
 // dimension_T is used for anything thats around the same magnitude as the board
 // pieces, it is signed on purpose
@@ -11,6 +31,44 @@ typedef signed char dimension_T;
 
 enum halma_piece { EMPTY = 0, RED = 1, YELLOW = 2, BLUE = 3, GREEN = 4 };
 
+// pieces are stored per player/set, RED is at index 0
+#define halma_set_index(set) ((set) - 1)
+
+// squares are the row major index of a tile, same as the bitboard index
+#define halma_square(y, x) (((y) * HALMA_SQUARE_ROOT) + (x))
+#define halma_square_y(square) ((square) / HALMA_SQUARE_ROOT)
+#define halma_square_x(square) ((square) % HALMA_SQUARE_ROOT)
+
+// builds with HALMA_MAILBOX defined also keep the board as a byte grid with a
+// two tile ring of off board tiles around it, and search for moves on that
+// instead of the bitboards
+#define HALMA_MAILBOX_RING 2
+#define HALMA_MAILBOX_STRIDE (HALMA_SQUARE_ROOT + (2 * HALMA_MAILBOX_RING))
+#define HALMA_MAILBOX_SIZE (HALMA_MAILBOX_STRIDE * HALMA_MAILBOX_STRIDE)
+#define HALMA_OFF_BOARD 0xFF
+#define halma_mailbox_cell(square)                                       \
+  (((halma_square_y(square) + HALMA_MAILBOX_RING) * HALMA_MAILBOX_STRIDE) + \
+   halma_square_x(square) + HALMA_MAILBOX_RING)
+
+// builds with HALMA_NNUE defined also keep the first layer of the neural
+// network evaluation worked out for every player, see halma_nnue.h
+#define HALMA_NNUE_HIDDEN 64
+
+/**
+ * @brief A single move packed into 16 bits, the square (see halma_square) it
+ * starts from in the high byte and the square it ends on in the low byte.
+ */
+typedef uint16_t halma_move_T;
+#define halma_move(from, to) ((halma_move_T)(((from) << 8) | (to)))
+#define halma_move_from(move) ((move) >> 8)
+#define halma_move_to(move) ((move) & 0xFF)
+
+// most moves a set could ever have, every piece moving to every tile the set
+// isn't sitting on. The real number is far smaller.
+#define HALMA_MAX_MOVES                                    \
+  (HALMA_MAX_PIECES *                                      \
+   ((HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT) - HALMA_MAX_PIECES))
+
 /**
  * @brief Structure that holds a bitmask and coordiante data for valid moves a
  * piece can make. If a function wants the array it will ask for moves or table,
@@ -19,14 +77,105 @@ enum halma_piece { EMPTY = 0, RED = 1, YELLOW = 2, BLUE = 3, GREEN = 4 };
  */
 struct halma_moves {
   bitmask_T* targets;
+  bitboard_T influence;  // tiles the targets depend on, see halma_update_moves
   dimension_T origin_y;
   dimension_T origin_x;
 };
 
+/**
+ * @brief Everything a move table needs, in one block the caller owns. Filling
+ * one with halma_gather_moves_into doesn't touch the heap, so keeping one
+ * around and refilling it every turn costs no allocations at all.
+ * moves has to stay the first member, halma_clear_moves relies on it.
+ */
+struct halma_moves_arena {
+  struct halma_moves moves[HALMA_MAX_PIECES];
+  bitmask_T masks[HALMA_MAX_PIECES];
+  bitblock_T storage[HALMA_MAX_PIECES]
+                    [BITMASK_BLOCKS(HALMA_SQUARE_ROOT, HALMA_SQUARE_ROOT)];
+};
+
+/**
+ * @brief Move tables for every set in the game, indexed with halma_set_index.
+ * Sets that aren't playing are NULL.
+ */
+struct halma_all_moves {
+  struct halma_moves* sets[HALMA_MAX_PLAYERS];
+};
+
+/**
+ * @brief One entry on an undo stack, everything halma_unmake_move needs to put
+ * the board back exactly how it was before the move. A pass is recorded with
+ * from and to being the same tile.
+ */
+struct halma_undo {
+  unsigned char from;
+  unsigned char to;
+  short turns;
+  uint64_t hash;
+  dimension_T goal_own[HALMA_MAX_PLAYERS];
+  dimension_T goal_foreign[HALMA_MAX_PLAYERS];
+  dimension_T goal_empty[HALMA_MAX_PLAYERS];
+  short distance[HALMA_MAX_PLAYERS];
+  short distance_squared[HALMA_MAX_PLAYERS];
+  dimension_T at_home[HALMA_MAX_PLAYERS];
+};
+
+/**
+ * @brief A stack of undo records on storage the caller owns, set it up with
+ * halma_init_undo. Making and unmaking moves never allocates.
+ */
+struct halma_undo_stack {
+  struct halma_undo* records;
+  int top;
+  int capacity;
+};
+
+/**
+ * @brief How many legal moves each piece, and each set as a whole, has. Pieces
+ * are in piece list order, same as move tables. Sets that aren't playing are
+ * all zeros.
+ */
+struct halma_mobility {
+  short sets[HALMA_MAX_PLAYERS];
+  short pieces[HALMA_MAX_PLAYERS][HALMA_MAX_PIECES];
+};
+
+/**
+ * @brief The board is stored as one bitboard (see bitboard.h) per player/set,
+ * plus the union of all of them. Sets that are not in the game are left empty.
+ * Goal areas are the same for every board of a variant and live in the tables
+ * in halma_tables.h. Use halma_get_piece or halma_board_view if
+ * you want to look at it like a grid.
+ */
 struct halma_board {
+  bitboard_T pieces[HALMA_MAX_PLAYERS];
+  bitboard_T occupied;
+  // per set counts of what is sitting in its goal, kept up to date as pieces
+  // move so checking for victory doesn't need to look at the board
+  dimension_T goal_own[HALMA_MAX_PLAYERS];
+  dimension_T goal_foreign[HALMA_MAX_PLAYERS];
+  dimension_T goal_empty[HALMA_MAX_PLAYERS];
+  // per set sums for the evaluation, kept up to date the same way: every
+  // piece's halma_goal_distances entry, the same squared, and how many pieces
+  // are still in the camp they started in
+  short distance[HALMA_MAX_PLAYERS];
+  short distance_squared[HALMA_MAX_PLAYERS];
+  dimension_T at_home[HALMA_MAX_PLAYERS];
+  // where each set's pieces are, and for every tile which entry in its set's
+  // list it is (-1 for empty tiles). A piece keeps its entry for the whole
+  // game, and move tables list pieces in the same order.
+  unsigned char piece_list[HALMA_MAX_PLAYERS][HALMA_MAX_PIECES];
+  dimension_T piece_index[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+#ifdef HALMA_MAILBOX
+  unsigned char mailbox[HALMA_MAILBOX_SIZE];
+#endif
+#ifdef HALMA_NNUE
+  int16_t nnue[HALMA_MAX_PLAYERS][HALMA_NNUE_HIDDEN];
+#endif
+  // Zobrist hash of the position and whose turn it is, see halma_tables.h
+  uint64_t hash;
   short turns;
-  enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT];
-  enum halma_piece victory_mask[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT];
   dimension_T player_pieces;
   dimension_T players;
 };
@@ -47,9 +196,45 @@ struct halma_board* halma_init_board_4p();
  */
 struct halma_board* halma_init_board_2p();
 
+/**
+ * @brief Finds which piece, if any, is sitting on a tile.
+ *
+ * @param board the current game board.
+ * @param y_index the y coordinate of the tile.
+ * @param x_index the x coordinate of the tile.
+ * @return enum halma_piece, EMPTY if there is nothing there.
+ */
+enum halma_piece halma_get_piece(struct halma_board* board,
+                                 dimension_T y_index, dimension_T x_index);
+
+/**
+ * @brief Finds where the piece on a tile is in its set's move table, without
+ * searching the table.
+ *
+ * @param board the current game board.
+ * @param y_index the y coordinate of the tile.
+ * @param x_index the x coordinate of the tile.
+ * @return dimension_T index into the move table of whatever set is on the
+ * tile, -1 if the tile is empty.
+ */
+dimension_T halma_piece_index(struct halma_board* board, dimension_T y_index,
+                              dimension_T x_index);
+
+/**
+ * @brief Expands the board into a plain grid of pieces, for anything that
+ * wants to draw it one tile at a time.
+ *
+ * @param board the board to expand.
+ * @param grid grid to fill in, indexed [y][x].
+ */
+void halma_board_view(struct halma_board* board,
+                      enum halma_piece grid[HALMA_SQUARE_ROOT]
+                                           [HALMA_SQUARE_ROOT]);
+
 /**
  * @brief Saves the current game to a file for loading later. The save file is a
- * binary format, the contents of board are written to the file as-is.
+ * binary format, the board is written out as a grid of pieces followed by a
+ * grid of goal areas, one byte per tile.
  * Everything but the number of turns is a single byte so endianness is not
  * generally a concern. Turns has some math done to it to handle poitential
  * endian hiccups.
@@ -69,12 +254,26 @@ int halma_save_game(const char* filename, struct halma_board* board);
  */
 struct halma_board* halma_load_game(const char* filename);
 
+/**
+ * @brief Fills in the move table for a set without allocating anything, see
+ * halma_gather_valid_moves for what the table contains.
+ *
+ * @param board current game board.
+ * @param set which player/set of pieces are we gathering the moves for.
+ * @param arena storage for the table, anything already in it is overwritten.
+ * @return struct halma_moves* the table, which lives inside arena.
+ */
+struct halma_moves* halma_gather_moves_into(struct halma_board* board,
+                                            enum halma_piece set,
+                                            struct halma_moves_arena* arena);
+
 /**
  * @brief Allocates an array of struct halma_moves with board->player_pieces
  * number of elements. Each instance of halma_moves contains the current
  * coordinates of the piece and a bitmask (like a 2D bitfield, see bitmask.h)
  * that contains an entry for every tile on the board. 0 if the piece cannot
- * move there, 1 if it can. Array is allocated on the heap.
+ * move there, 1 if it can. Array is allocated on the heap, in a single
+ * struct halma_moves_arena.
  *
  * @param board current game board.
  * @param set which player/set of pieces are we gathering the moves for.
@@ -83,6 +282,90 @@ struct halma_board* halma_load_game(const char* filename);
 struct halma_moves* halma_gather_valid_moves(struct halma_board* board,
                                              enum halma_piece set);
 
+/**
+ * @brief Lists every legal move for a set as packed (from, to) pairs, the same
+ * moves halma_gather_valid_moves would find but without a table to scan. Moves
+ * are grouped by piece in piece list order. Nothing is allocated.
+ *
+ * @param board current game board.
+ * @param set which player/set of pieces are we gathering the moves for.
+ * @param moves filled with the moves, has to have room for HALMA_MAX_MOVES.
+ * @return int number of moves written.
+ */
+int halma_generate_moves(struct halma_board* board, enum halma_piece set,
+                         halma_move_T moves[HALMA_MAX_MOVES]);
+
+/**
+ * @brief Every tile the piece of set on square can legally move to, with the
+ * victory area rule applied. For looking at one piece without generating the
+ * moves of the whole set.
+ *
+ * @param board current game board.
+ * @param set the player/set the piece belongs to.
+ * @param square square (see halma_square) the piece is on.
+ * @param influence if not NULL, set to the tiles the targets depend on, see
+ * halma_update_moves.
+ * @return bitboard_T the tiles the piece can move to.
+ */
+bitboard_T halma_piece_targets(struct halma_board* board, enum halma_piece set,
+                               int square, bitboard_T* influence);
+
+/**
+ * @brief Counts the legal moves of every piece of every set in the game in one
+ * go, without building move tables or move lists. Counts match what
+ * halma_generate_moves would return. Rather than searching every piece's
+ * jumps on its own, the empty tiles jumps link together are grouped once for
+ * the whole board, and a piece's count is its steps plus the size of every
+ * group its first jumps land in.
+ *
+ * @param board current game board.
+ * @param mobility filled in with the counts.
+ */
+void halma_count_mobility(struct halma_board* board,
+                          struct halma_mobility* mobility);
+
+/**
+ * @brief Brings a move table up to date after a move has been accepted into
+ * the board. Only the pieces whose moves could have been changed by the
+ * two tiles involved are searched again, every other entry is left as-is.
+ * Works for tables of any set, not just the one that moved.
+ *
+ * @param board the game board, with the move already applied.
+ * @param moves_table table from halma_gather_valid_moves for the board as it
+ * was before the move.
+ * @param from_y the y coordinate the piece moved from.
+ * @param from_x the x coordinate the piece moved from.
+ * @param to_y the y coordinate the piece moved to.
+ * @param to_x the x coordinate the piece moved to.
+ */
+void halma_update_moves(struct halma_board* board,
+                        struct halma_moves* moves_table, dimension_T from_y,
+                        dimension_T from_x, dimension_T to_y,
+                        dimension_T to_x);
+
+/**
+ * @brief Runs halma_gather_valid_moves for every set in the game.
+ *
+ * @param board current game board.
+ * @param all_moves where to put the tables.
+ */
+void halma_gather_all_moves(struct halma_board* board,
+                            struct halma_all_moves* all_moves);
+
+/**
+ * @brief Runs halma_update_moves on every table in all_moves.
+ */
+void halma_update_all_moves(struct halma_board* board,
+                            struct halma_all_moves* all_moves,
+                            dimension_T from_y, dimension_T from_x,
+                            dimension_T to_y, dimension_T to_x);
+
+/**
+ * @brief Deallocates every table in all_moves and sets them to NULL.
+ */
+void halma_clear_all_moves(struct halma_board* board,
+                           struct halma_all_moves* all_moves);
+
 /**
  * @brief Deallocates the array of struct halma_moves that was allocated by
  * halma_gather_valid_moves.
@@ -142,10 +425,85 @@ dimension_T halma_accept_move(struct halma_board* board,
                               struct halma_moves* move, dimension_T y_index,
                               dimension_T x_index);
 
+/**
+ * @brief Checks a single move without building a move table, for moves coming
+ * from somewhere other than the move tables (a file, another program). The
+ * piece on from has to belong to whoever's turn it is, and the victory area
+ * rule is applied. The jump search stops as soon as it lands on to.
+ *
+ * @param board the current game board.
+ * @param from square (see halma_square) of the piece to move.
+ * @param to square to move it to.
+ * @return true if the move is legal, false otherwise.
+ */
+bool halma_is_legal_move(struct halma_board* board, int from, int to);
+
+/**
+ * @brief Sets up an empty undo stack on storage the caller owns.
+ *
+ * @param stack the stack to set up.
+ * @param records storage for the records, one per move that can be undone.
+ * @param capacity how many records fit in records.
+ */
+void halma_init_undo(struct halma_undo_stack* stack, struct halma_undo* records,
+                     int capacity);
+
+/**
+ * @brief Moves the piece on from to the tile to and pushes what's needed to
+ * undo it onto stack. Unlike halma_accept_move it does NOT validate the move
+ * and doesn't need a move table, it is meant for searches that already know
+ * the move is legal. Passing the same tile as from and to passes the turn.
+ *
+ * @param board the current game board.
+ * @param stack undo stack to push the move onto.
+ * @param from square (see halma_square) of the piece to move.
+ * @param to empty square to move it to.
+ * @return dimension_T 0 on success, -1 if the stack is full, -2 if turns
+ * would overflow. The board isn't touched on failure.
+ */
+dimension_T halma_make_move(struct halma_board* board,
+                            struct halma_undo_stack* stack, int from, int to);
+
+/**
+ * @brief Takes back the last move made with halma_make_move, the board ends up
+ * exactly how it was before that move.
+ *
+ * @param board the current game board.
+ * @param stack undo stack the move was pushed onto.
+ * @return dimension_T 0 on success, -1 if there was nothing to undo.
+ */
+dimension_T halma_unmake_move(struct halma_board* board,
+                              struct halma_undo_stack* stack);
+
+/**
+ * @brief Moves the piece on from to the tile to and hands the turn on, without
+ * keeping anything to undo it with. Meant for playing games out as fast as
+ * possible: like halma_make_move it doesn't validate the move, and passing the
+ * same tile as from and to passes the turn. The caller has to make sure turns
+ * can't overflow.
+ *
+ * @param board the current game board.
+ * @param from square (see halma_square) of the piece to move.
+ * @param to empty square to move it to.
+ * @return enum halma_piece the player/set that won with this move, EMPTY if
+ * nobody did. Only the goals the move could have filled are checked, so a
+ * board that was already won before the move isn't noticed.
+ */
+enum halma_piece halma_play_move(struct halma_board* board, int from, int to);
+
+/**
+ * @brief Skips the current player/set's turn, for when they have no moves.
+ *
+ * @param board the current game board.
+ * @return dimension_T 0 on success, -2 if turns overflow.
+ */
+dimension_T halma_pass_turn(struct halma_board* board);
+
 /**
  * @brief Checks to see if there are ANY moves available for the current
  * player/set. It should be very very rare that there are no moves available but
- * its technically possible.
+ * its technically possible. Doesn't change anything, if there are no moves use
+ * halma_pass_turn to skip the turn.
  *
  * @param board the current game board.
  * @param moves full move table.
@@ -0,0 +1,595 @@
+/* halma_bench.c
+ * Benchmarks for the computer player's building blocks, run one with
+ * 'halma_bench <name> [argument]'. Results are reported per core (or per
+ * thread) so they can be compared between machines.
+ *   playout [seconds]: every core plays games out at once.
+ *   smp [depth]: searches the same positions with 1, 2, 4... threads up to one
+ *     per core, and reports how much faster the search got, how often the
+ *     first move searched was enough for a cutoff and how the transposition
+ *     table was used.
+ *   mcts [seconds]: runs the Monte Carlo tree search on the same positions
+ *     with 1, 2, 4... threads up to one per core, and reports how many
+ *     iterations each thread gets through and how much faster that is overall.
+ *   mobility [seconds]: counts every piece's moves in the same positions with
+ *     halma_count_mobility, and by generating every set's moves.
+ *   nnue [weights file]: evaluates the same positions with the built in
+ *     evaluation and the neural network, on one core. Without a weights file
+ *     the network gets random weights, which are just as fast. Needs a build
+ *     with HALMA_NNUE.
+ * There is also a consistency check that doesn't time anything:
+ *   check [games]: plays seeded random games, and after every ply checks the
+ *     move tables kept up to date with halma_update_all_moves against fresh
+ *     ones, halma_generate_moves against the tables and halma_is_legal_move,
+ *     every piece's halma_piece_targets against a plain recursive jump search,
+ *     halma_count_mobility against those targets, and that unmaking a move
+ *     puts the board back exactly. Exits with 1 if anything differs.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "halma.h"
+#include "halma_engine.h"
+#include "halma_mcts.h"
+#include "halma_playout.h"
+#include "halma_tables.h"
+#ifdef HALMA_NNUE
+#include "halma_eval.h"
+#include "halma_nnue.h"
+#endif
+
+#define EXIT_THREAD_ERROR 40
+#define DEFAULT_SECONDS 5
+#define DEFAULT_DEPTH 4
+// plies per player played out from the start for the search benchmark, to
+// get to a position with some play in it
+#define SMP_OPENING_PLIES 12
+// how long the tree search benchmark runs with each thread count
+#define MCTS_DEFAULT_SECONDS 2
+// positions the mobility and evaluation benchmarks go over again and again,
+// from games played out to different lengths
+#define BENCH_POSITIONS 1024
+// games the consistency check plays by default, and the most plies each
+#define CHECK_DEFAULT_GAMES 100
+#define CHECK_MAX_PLIES 400
+
+static const char* set_names[] = {"RED", "YELLOW", "BLUE", "GREEN"};
+
+struct playout_bench {
+  struct halma_board* start;
+  double seconds;
+  struct halma_rng rng;
+  unsigned long long playouts;
+  unsigned long long plies;
+  unsigned long long stopped;
+  unsigned long long wins[HALMA_MAX_PLAYERS];
+};
+
+static void* playout_bench_main(void* arg) {
+  struct playout_bench* bench = arg;
+  double deadline = halma_engine_clock() + bench->seconds;
+  while (halma_engine_clock() < deadline) {
+    struct halma_board board = *bench->start;
+    enum halma_piece winner =
+        halma_playout(&board, &bench->rng, HALMA_PLAYOUT_MAX_PLIES);
+    bench->playouts++;
+    bench->plies += board.turns - bench->start->turns;
+    if (winner == EMPTY)
+      bench->stopped++;
+    else
+      bench->wins[halma_set_index(winner)]++;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Plays games out from the start position on every core for a while
+ * and reports how many got played.
+ */
+static void bench_playouts(struct halma_board* start, int cores,
+                           double seconds) {
+  pthread_t threads[cores];
+  struct playout_bench benches[cores];
+  for (int i = 0; i < cores; i++) {
+    memset(&benches[i], 0, sizeof(struct playout_bench));
+    benches[i].start = start;
+    benches[i].seconds = seconds;
+    halma_rng_seed(&benches[i].rng, i);
+    if (pthread_create(&threads[i], NULL, playout_bench_main, &benches[i]))
+      exit(EXIT_THREAD_ERROR);
+  }
+
+  struct playout_bench total = {0};
+  for (int i = 0; i < cores; i++) {
+    pthread_join(threads[i], NULL);
+    total.playouts += benches[i].playouts;
+    total.plies += benches[i].plies;
+    total.stopped += benches[i].stopped;
+    for (int set = 0; set < HALMA_MAX_PLAYERS; set++)
+      total.wins[set] += benches[i].wins[set];
+  }
+
+  printf("%d players: %llu playouts, %.0f per second per core, ",
+         start->players, total.playouts, total.playouts / seconds / cores);
+  printf("%.1f plies each\n",
+         total.playouts ? (double)total.plies / total.playouts : 0);
+  printf("  wins:");
+  for (int set = 0; set < start->players; set++)
+    printf(" %s %llu", set_names[set], total.wins[set]);
+  printf(", stopped at %d plies %llu\n", HALMA_PLAYOUT_MAX_PLIES,
+         total.stopped);
+}
+
+/**
+ * @brief Searches board to depth with more and more threads, starting from an
+ * empty table every time, and reports the speedup over a single thread.
+ */
+static void bench_smp(struct halma_board* board, int cores, int depth) {
+  struct halma_limits limits = {depth, 0, HALMA_SEARCH_PARANOID, 1};
+  double single = 0;
+  printf("%d players, depth %d:\n", board->players, depth);
+  for (int threads = 1; threads <= cores; threads *= 2) {
+    limits.threads = threads;
+    halma_engine_new_game();
+    struct halma_search_result result = halma_engine_best_move(board, &limits);
+    if (threads == 1) single = result.seconds;
+    printf("  %2d threads: %7.3f seconds, %10llu nodes, %8.0f nodes per "
+           "second per thread, speedup %.2f, first move cutoffs %.1f%%\n",
+           threads, result.seconds, result.nodes,
+           result.nodes / result.seconds / threads, single / result.seconds,
+           result.cutoffs ? 100.0 * result.first_cutoffs / result.cutoffs : 0);
+    printf("              table hits %.1f%% of %llu probes, %llu stores, "
+           "%llu replacing other positions, %.1f%% full\n",
+           result.tt.probes ? 100.0 * result.tt.hits / result.tt.probes : 0,
+           result.tt.probes, result.tt.stores, result.tt.replacements,
+           result.tt_permille / 10.0);
+    // the last run always uses every core
+    if (threads < cores && threads * 2 > cores) threads = cores / 2;
+  }
+}
+
+/**
+ * @brief Runs the tree search on board for a while with more and more
+ * threads, on a new tree every time, and reports the speedup over a single
+ * thread.
+ */
+static void bench_mcts(struct halma_board* board, int cores, double seconds) {
+  double single = 0;
+  printf("%d players:\n", board->players);
+  for (int threads = 1; threads <= cores; threads *= 2) {
+    struct halma_mcts_config config = {threads};
+    struct halma_mcts* mcts = halma_mcts_create(&config);
+    struct halma_mcts_limits limits = {0, halma_engine_clock() + seconds};
+    struct halma_search_result result =
+        halma_mcts_best_move(mcts, board, &limits);
+    halma_mcts_destroy(mcts);
+    double rate = result.nodes / result.seconds;
+    if (threads == 1) single = rate;
+    printf("  %2d threads: %10llu iterations, %8.0f per second per thread, "
+           "speedup %.2f, %d plies deep\n",
+           threads, result.nodes, rate / threads, rate / single, result.depth);
+    // the last run always uses every core
+    if (threads < cores && threads * 2 > cores) threads = cores / 2;
+  }
+}
+
+/**
+ * @brief Plays 2 and 4 player games out to different lengths, for the
+ * benchmarks that go over lots of positions.
+ * @return struct halma_board* BENCH_POSITIONS boards, free them when done.
+ */
+static struct halma_board* bench_positions() {
+  struct halma_board* boards =
+      malloc(BENCH_POSITIONS * sizeof(struct halma_board));
+  if (boards == NULL) exit(EXIT_FAILURE);
+  struct halma_rng rng;
+  halma_rng_seed(&rng, 0);
+  for (int i = 0; i < BENCH_POSITIONS; i++) {
+    struct halma_board* board =
+        i % 2 ? halma_init_board_4p() : halma_init_board_2p();
+    halma_playout(board, &rng, board->players * (i % 64));
+    boards[i] = *board;
+    halma_end_game(board);
+  }
+  return boards;
+}
+
+/**
+ * @brief Counts the moves of every piece of every set in every position over
+ * and over for a while, either with halma_count_mobility or by generating
+ * each set's moves.
+ * @return double positions per second.
+ */
+static double bench_counting(struct halma_board* boards, bool generate,
+                             double seconds) {
+  static halma_move_T moves[HALMA_MAX_MOVES];
+  struct halma_mobility mobility;
+  unsigned long long positions = 0;
+  volatile int total = 0;  // so the counting can't be left out
+  double start = halma_engine_clock();
+  while (halma_engine_clock() < start + seconds) {
+    for (int i = 0; i < BENCH_POSITIONS; i++) {
+      if (generate) {
+        for (int set = 0; set < boards[i].players; set++)
+          total += halma_generate_moves(&boards[i], set + 1, moves);
+      } else {
+        halma_count_mobility(&boards[i], &mobility);
+        total += mobility.sets[0];
+      }
+    }
+    positions += BENCH_POSITIONS;
+  }
+  return positions / (halma_engine_clock() - start);
+}
+
+static void bench_mobility(double seconds) {
+  struct halma_board* boards = bench_positions();
+  double counted = bench_counting(boards, false, seconds);
+  double generated = bench_counting(boards, true, seconds);
+  printf("%d positions, %.1f seconds each\n", BENCH_POSITIONS, seconds);
+  printf("  halma_count_mobility:  %10.0f positions per second\n", counted);
+  printf("  halma_generate_moves:  %10.0f positions per second, every set\n",
+         generated);
+  free(boards);
+}
+
+#ifdef HALMA_NNUE
+/**
+ * @brief Evaluates every position for whoever's turn it is, over and over for
+ * a while.
+ * @return double evaluations per second.
+ */
+static double bench_evaluations(struct halma_board* boards, int count,
+                                double seconds) {
+  unsigned long long evaluations = 0;
+  volatile int total = 0;  // so the evaluations can't be left out
+  double start = halma_engine_clock();
+  while (halma_engine_clock() < start + seconds) {
+    for (int i = 0; i < count; i++)
+      total += halma_evaluate(&boards[i], halma_whos_turn(&boards[i]));
+    evaluations += count;
+  }
+  return evaluations / (halma_engine_clock() - start);
+}
+
+/**
+ * @brief Makes and unmakes a move in every position over and over for a
+ * while, which is where the network's accumulators get updated.
+ * @return double moves made and unmade per second.
+ */
+static double bench_moves(struct halma_board* boards, const halma_move_T* moves,
+                          int count, double seconds) {
+  struct halma_undo record;
+  struct halma_undo_stack undo;
+  halma_init_undo(&undo, &record, 1);
+  unsigned long long made = 0;
+  double start = halma_engine_clock();
+  while (halma_engine_clock() < start + seconds) {
+    for (int i = 0; i < count; i++) {
+      if (halma_make_move(&boards[i], &undo, halma_move_from(moves[i]),
+                          halma_move_to(moves[i])) == 0)
+        halma_unmake_move(&boards[i], &undo);
+    }
+    made += count;
+  }
+  return made / (halma_engine_clock() - start);
+}
+
+static void bench_nnue(const char* filename, double seconds) {
+  struct halma_board* boards = bench_positions();
+  halma_move_T* moves = malloc(BENCH_POSITIONS * sizeof(halma_move_T));
+  static halma_move_T generated[HALMA_MAX_MOVES];
+  if (moves == NULL) exit(EXIT_FAILURE);
+  for (int i = 0; i < BENCH_POSITIONS; i++) {
+    int count = halma_generate_moves(&boards[i], halma_whos_turn(&boards[i]),
+                                     generated);
+    moves[i] = count ? generated[0] : halma_move(0, 0);
+  }
+
+  double built_in = bench_evaluations(boards, BENCH_POSITIONS, seconds);
+  double built_in_moves = bench_moves(boards, moves, BENCH_POSITIONS, seconds);
+  if (filename == NULL) {
+    halma_nnue_randomize(0);
+  } else if (!halma_nnue_load(filename)) {
+    fprintf(stderr, "couldn't load a network from %s\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < BENCH_POSITIONS; i++) halma_nnue_refresh(&boards[i]);
+
+  printf("%d positions, %.1f seconds each\n", BENCH_POSITIONS, seconds);
+  printf("  built in:       %10.0f evaluations, %10.0f moves per second\n",
+         built_in, built_in_moves);
+  if (halma_nnue_use_simd(true))
+    printf("  network, AVX2:  %10.0f evaluations, %10.0f moves per second\n",
+           bench_evaluations(boards, BENCH_POSITIONS, seconds),
+           bench_moves(boards, moves, BENCH_POSITIONS, seconds));
+  else
+    printf("  network, AVX2:  not supported by this CPU\n");
+  halma_nnue_use_simd(false);
+  printf("  network, scalar:%10.0f evaluations, %10.0f moves per second\n",
+         bench_evaluations(boards, BENCH_POSITIONS, seconds),
+         bench_moves(boards, moves, BENCH_POSITIONS, seconds));
+  free(moves);
+  free(boards);
+}
+#endif
+
+/**
+ * @brief What the consistency check found, every count but plies should be 0.
+ */
+struct check_counts {
+  unsigned long long plies;
+  unsigned long long tables;     // updated move tables that differ from fresh
+  unsigned long long generator;  // generated moves that disagree with a table
+                                 // or with halma_is_legal_move
+  unsigned long long reference;  // positions where a piece's targets differ
+                                 // from the recursive jump search
+  unsigned long long mobility;   // positions halma_count_mobility miscounted
+  unsigned long long unmake;     // boards unmake didn't put back exactly
+};
+
+/**
+ * @brief Compares two sets of move tables for the same board entry by entry.
+ */
+static bool check_tables(struct halma_board* board,
+                         struct halma_all_moves* updated,
+                         struct halma_all_moves* fresh) {
+  for (int set = 0; set < board->players; set++)
+    for (dimension_T i = 0; i < board->player_pieces; i++) {
+      struct halma_moves* a = &updated->sets[set][i];
+      struct halma_moves* b = &fresh->sets[set][i];
+      if (a->origin_y != b->origin_y || a->origin_x != b->origin_x)
+        return false;
+      for (dimension_T y = 0; y < HALMA_SQUARE_ROOT; y++)
+        for (dimension_T x = 0; x < HALMA_SQUARE_ROOT; x++)
+          if (getbit(a->targets, y, x) != getbit(b->targets, y, x))
+            return false;
+    }
+  return true;
+}
+
+/**
+ * @brief Checks a set's generated moves are all legal and as many as its move
+ * table has.
+ */
+static bool check_generated(struct halma_board* board,
+                            struct halma_moves* table,
+                            const halma_move_T* moves, int count) {
+  unsigned long targets = 0;
+  for (dimension_T i = 0; i < board->player_pieces; i++)
+    targets += countbits(table[i].targets);
+  if (targets != count) return false;
+  for (int i = 0; i < count; i++)
+    if (!halma_is_legal_move(board, halma_move_from(moves[i]),
+                             halma_move_to(moves[i])))
+      return false;
+  return true;
+}
+
+/**
+ * @brief The recursive jump search move tables were built with before the jump
+ * tables, kept as a reference: marks every empty tile a chain of jumps from
+ * y, x can land on.
+ */
+static void check_jumps(enum halma_piece grid[][HALMA_SQUARE_ROOT],
+                        bitboard_T* jumps, int y, int x) {
+  for (int dy = -1; dy <= 1; dy++)
+    for (int dx = -1; dx <= 1; dx++) {
+      int landing_y = y + 2 * dy;
+      int landing_x = x + 2 * dx;
+      if ((dy == 0 && dx == 0) || landing_y < 0 ||
+          landing_y >= HALMA_SQUARE_ROOT || landing_x < 0 ||
+          landing_x >= HALMA_SQUARE_ROOT)
+        continue;
+      if (grid[y + dy][x + dx] == EMPTY ||
+          grid[landing_y][landing_x] != EMPTY)
+        continue;
+      int landing = halma_square(landing_y, landing_x);
+      if (bitboard_getbit(jumps, landing)) continue;
+      bitboard_setbit(jumps, landing);
+      check_jumps(grid, jumps, landing_y, landing_x);
+    }
+}
+
+/**
+ * @brief Checks every piece's halma_piece_targets against check_jumps plus its
+ * steps, with the victory area rule applied the same way.
+ */
+static bool check_reference(struct halma_board* board) {
+  enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT];
+  halma_board_view(board, grid);
+  for (int set = 0; set < board->players; set++) {
+    bitboard_T goal = halma_goal(board, set + 1);
+    for (dimension_T i = 0; i < board->player_pieces; i++) {
+      int square = board->piece_list[set][i];
+      int y = halma_square_y(square);
+      int x = halma_square_x(square);
+      bitboard_T steps = bitboard_empty();
+      bitboard_T jumps = bitboard_empty();
+      for (int ny = y - 1; ny <= y + 1; ny++)
+        for (int nx = x - 1; nx <= x + 1; nx++)
+          if (ny >= 0 && ny < HALMA_SQUARE_ROOT && nx >= 0 &&
+              nx < HALMA_SQUARE_ROOT && grid[ny][nx] == EMPTY)
+            bitboard_setbit(&steps, halma_square(ny, nx));
+      check_jumps(grid, &jumps, y, x);
+      bitboard_T targets = bitboard_or(steps, jumps);
+      if (bitboard_getbit(&goal, square)) targets = bitboard_and(targets, goal);
+      if (!bitboard_equal(targets,
+                          halma_piece_targets(board, set + 1, square, NULL)))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Checks halma_count_mobility against counting every piece's
+ * halma_piece_targets.
+ */
+static bool check_mobility(struct halma_board* board) {
+  struct halma_mobility mobility;
+  halma_count_mobility(board, &mobility);
+  for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+    int total = 0;
+    for (dimension_T i = 0; set < board->players && i < board->player_pieces;
+         i++) {
+      int count = bitboard_popcount(halma_piece_targets(
+          board, set + 1, board->piece_list[set][i], NULL));
+      if (mobility.pieces[set][i] != count) return false;
+      total += count;
+    }
+    if (mobility.sets[set] != total) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Plays random moves on board until someone wins or CHECK_MAX_PLIES,
+ * checking everything after every ply.
+ */
+static void check_game(struct halma_board* board, struct halma_rng* rng,
+                       struct check_counts* counts) {
+  static halma_move_T moves[HALMA_MAX_MOVES];
+  struct halma_all_moves tables, fresh;
+  struct halma_undo record;
+  struct halma_undo_stack undo;
+  halma_init_undo(&undo, &record, 1);
+  halma_gather_all_moves(board, &tables);
+
+  for (int ply = 0;
+       ply < CHECK_MAX_PLIES && halma_check_victory_all(board) == EMPTY;
+       ply++) {
+    enum halma_piece turn = halma_whos_turn(board);
+    struct halma_moves* table = tables.sets[halma_set_index(turn)];
+    int count = halma_generate_moves(board, turn, moves);
+    if (!check_generated(board, table, moves, count)) counts->generator++;
+    if (!check_reference(board)) counts->reference++;
+    if (!check_mobility(board)) counts->mobility++;
+    counts->plies++;
+    if (count == 0) {
+      halma_pass_turn(board);
+      continue;
+    }
+    halma_move_T move = moves[halma_rng_next(rng) % count];
+    int from = halma_move_from(move);
+    int to = halma_move_to(move);
+
+    struct halma_board before = *board;
+    if (halma_make_move(board, &undo, from, to) != 0 ||
+        halma_unmake_move(board, &undo) != 0 ||
+        memcmp(&before, board, sizeof(struct halma_board)) != 0)
+      counts->unmake++;
+
+    dimension_T index =
+        halma_piece_index(board, halma_square_y(from), halma_square_x(from));
+    halma_accept_move(board, &table[index], halma_square_y(to),
+                      halma_square_x(to));
+    halma_update_all_moves(board, &tables, halma_square_y(from),
+                           halma_square_x(from), halma_square_y(to),
+                           halma_square_x(to));
+    halma_gather_all_moves(board, &fresh);
+    if (!check_tables(board, &tables, &fresh)) counts->tables++;
+    halma_clear_all_moves(board, &fresh);
+  }
+  halma_clear_all_moves(board, &tables);
+}
+
+static bool check(int games) {
+  struct check_counts counts = {0};
+  struct halma_rng rng;
+  halma_rng_seed(&rng, 0);
+  for (int game = 0; game < games; game++) {
+    struct halma_board* board =
+        game % 2 ? halma_init_board_4p() : halma_init_board_2p();
+    check_game(board, &rng, &counts);
+    halma_end_game(board);
+  }
+  printf("%d games, %llu plies: %llu move table, %llu move generator, %llu "
+         "jump search, %llu mobility and %llu unmake mismatches\n",
+         games, counts.plies, counts.tables, counts.generator,
+         counts.reference, counts.mobility, counts.unmake);
+  return counts.tables == 0 && counts.generator == 0 &&
+         counts.reference == 0 && counts.mobility == 0 && counts.unmake == 0;
+}
+
+int main(int argc, char** argv) {
+  bool playout = argc >= 2 && strcmp(argv[1], "playout") == 0;
+  bool smp = argc >= 2 && strcmp(argv[1], "smp") == 0;
+  bool mcts = argc >= 2 && strcmp(argv[1], "mcts") == 0;
+  bool mobility = argc >= 2 && strcmp(argv[1], "mobility") == 0;
+  bool nnue = argc >= 2 && strcmp(argv[1], "nnue") == 0;
+  bool consistency = argc >= 2 && strcmp(argv[1], "check") == 0;
+  if (!playout && !smp && !mcts && !mobility && !nnue && !consistency) {
+    fprintf(stderr,
+            "usage: %s playout [seconds] | smp [depth] | mcts [seconds] | "
+            "mobility [seconds] | nnue [weights file] | check [games]\n",
+            argv[0]);
+    return 1;
+  }
+  if (consistency) {
+    int games = argc > 2 ? atoi(argv[2]) : CHECK_DEFAULT_GAMES;
+    return check(games > 0 ? games : CHECK_DEFAULT_GAMES) ? 0 : 1;
+  }
+  if (mobility) {
+    double seconds = argc > 2 ? atof(argv[2]) : DEFAULT_SECONDS;
+    bench_mobility(seconds > 0 ? seconds : DEFAULT_SECONDS);
+    return 0;
+  }
+  if (nnue) {
+#ifdef HALMA_NNUE
+    bench_nnue(argc > 2 ? argv[2] : NULL, DEFAULT_SECONDS);
+    return 0;
+#else
+    fprintf(stderr, "the network evaluation needs a build with NNUE=1\n");
+    return 1;
+#endif
+  }
+  int cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1) cores = 1;
+
+  if (playout) {
+    double seconds = argc > 2 ? atof(argv[2]) : DEFAULT_SECONDS;
+    if (seconds <= 0) seconds = DEFAULT_SECONDS;
+    printf("%dx%d board, %d cores, %.1f seconds each\n", HALMA_SQUARE_ROOT,
+           HALMA_SQUARE_ROOT, cores, seconds);
+    struct halma_board* board = halma_init_board_2p();
+    bench_playouts(board, cores, seconds);
+    halma_end_game(board);
+    board = halma_init_board_4p();
+    bench_playouts(board, cores, seconds);
+    halma_end_game(board);
+  } else if (mcts) {
+    double seconds = argc > 2 ? atof(argv[2]) : MCTS_DEFAULT_SECONDS;
+    if (seconds <= 0) seconds = MCTS_DEFAULT_SECONDS;
+    printf("%dx%d board, %d cores, %.1f seconds each\n", HALMA_SQUARE_ROOT,
+           HALMA_SQUARE_ROOT, cores, seconds);
+    struct halma_rng rng;
+    halma_rng_seed(&rng, 0);
+    struct halma_board* board = halma_init_board_2p();
+    halma_playout(board, &rng, board->players * SMP_OPENING_PLIES);
+    bench_mcts(board, cores, seconds);
+    halma_end_game(board);
+    board = halma_init_board_4p();
+    halma_playout(board, &rng, board->players * SMP_OPENING_PLIES);
+    bench_mcts(board, cores, seconds);
+    halma_end_game(board);
+  } else {
+    int depth = argc > 2 ? atoi(argv[2]) : DEFAULT_DEPTH;
+    if (depth <= 0) depth = DEFAULT_DEPTH;
+    printf("%dx%d board, %d cores\n", HALMA_SQUARE_ROOT, HALMA_SQUARE_ROOT,
+           cores);
+    struct halma_rng rng;
+    halma_rng_seed(&rng, 0);
+    struct halma_board* board = halma_init_board_2p();
+    halma_playout(board, &rng, board->players * SMP_OPENING_PLIES);
+    bench_smp(board, cores, depth);
+    halma_end_game(board);
+    board = halma_init_board_4p();
+    halma_playout(board, &rng, board->players * SMP_OPENING_PLIES);
+    bench_smp(board, cores, depth);
+    halma_end_game(board);
+  }
+  return 0;
+}
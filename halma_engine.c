@@ -0,0 +1,873 @@
+#include "halma_engine.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "halma_eval.h"
+#include "halma_tables.h"
+#include "halma_tt.h"
+
+#define EXIT_MALLOC_ERROR 39
+#define EXIT_THREAD_ERROR 40
+
+// size of the transposition table shared by every search
+#define HALMA_ENGINE_TT_MB 16
+// half the width of the first aspiration window, in evaluation units
+#define HALMA_ASPIRATION_WINDOW 8
+// nodes each thread counts on its own before adding them to the total, when
+// there is more than one thread
+#define HALMA_NODE_BATCH 256
+// how often, in nodes, each thread looks at the clock. Together with the time
+// it takes to unwind and join the threads this bounds how far past the
+// deadline a search can go.
+#define HALMA_CLOCK_CHECK 16
+// time held back from a timed move's budget to cover that overshoot, seconds
+#define HALMA_TIME_RESERVE 0.005
+// share of a timed move's budget it gets to start new iterations in, for the
+// opening and endgame, and for the middle of the game where the most is
+// going on
+#define HALMA_TIME_SHARE_EDGES 0.4
+#define HALMA_TIME_SHARE_MIDDLE 1.0
+// how many times longer an iteration is expected to take than the one before
+#define HALMA_TIME_GROWTH 6
+// moves that caused a cutoff remembered for each ply, they're likely to cause
+// one in the positions next to it too
+#define HALMA_KILLERS 2
+// history scores stay within this either way
+#define HALMA_HISTORY_MAX 8192
+// how much each step a move takes toward the goal counts when ordering moves,
+// a good enough history can make up a few steps
+#define HALMA_PROGRESS_WEIGHT 1024
+// moves the picker sorts, after that a cutoff is unlikely and they're
+// searched in whatever order they were generated
+#define HALMA_PICK_SORTED 8
+// ordering score of a killer move, more than progress and history can add up
+// to
+#define HALMA_KILLER_SCORE (1 << 24)
+
+// scores this close to HALMA_SCORE_WIN are wins found some number of moves
+// from the node, see tt_score_to / tt_score_from
+#define is_win_score(score) (abs(score) > HALMA_SCORE_WIN - HALMA_MAX_PLY)
+
+static struct halma_tt* engine_tt = NULL;
+
+/**
+ * @brief What every thread searching the same position shares, on top of the
+ * transposition table.
+ */
+struct halma_smp {
+  double soft_deadline;  // no new iterations after this, 0 for none
+  _Atomic bool stop;
+  _Atomic unsigned long long nodes;  // every thread's nodes, give or take a
+                                     // batch per thread
+};
+
+/**
+ * @brief Everything a single search thread works on. The board is a private
+ * copy that moves are made and unmade on, and every ply has its own move list.
+ * Thread 0 is the main thread, the others are helpers that search the same
+ * position to fill the table for it (Lazy SMP).
+ */
+struct halma_search {
+  struct halma_smp* smp;
+  int id;
+  struct halma_board board;
+  struct halma_undo records[HALMA_MAX_PLY];
+  struct halma_undo_stack undo;
+  halma_move_T moves[HALMA_MAX_PLY][HALMA_MAX_MOVES];
+  const struct halma_limits* limits;
+  enum halma_piece root;  // the player the search is for
+  unsigned long long nodes;
+  unsigned long long counted;  // nodes already added to smp->nodes
+  unsigned long long node_batch;
+  bool stopped;
+  halma_move_T root_move;  // best move at the root in the current iteration
+  halma_move_T last_root_move;  // and in the last iteration
+  double iteration_start;  // halma_engine_clock() time of the current one
+  struct halma_search_result result;  // from the deepest finished iteration
+  // move ordering, see struct move_picker
+  int scores[HALMA_MAX_PLY][HALMA_MAX_MOVES];
+  halma_move_T killers[HALMA_MAX_PLY][HALMA_KILLERS];
+  int history[HALMA_MAX_PLAYERS][HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT]
+             [HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+  unsigned long long cutoffs;
+  unsigned long long first_cutoffs;  // on the first move searched
+  struct halma_tt_stats tt;  // this thread's table use
+};
+
+/* Win scores count moves from the root, but a table entry can be used at any
+ * depth, so they are stored counting moves from the node instead.
+ */
+static int tt_score_to(int score, int ply) {
+  if (!is_win_score(score)) return score;
+  return score > 0 ? score + ply : score - ply;
+}
+
+static int tt_score_from(int score, int ply) {
+  if (!is_win_score(score)) return score;
+  return score > 0 ? score - ply : score + ply;
+}
+
+/**
+ * @brief Makes a move on the search's board. The undo stack has room for every
+ * ply, so this only fails once the game has run out of turns. Nothing is made
+ * then, and the caller scores the node as it stands rather than unmaking.
+ */
+static bool search_make(struct halma_search* search, halma_move_T move) {
+  return halma_make_move(&search->board, &search->undo, halma_move_from(move),
+                         halma_move_to(move)) == 0;
+}
+
+double halma_engine_clock() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Checks if this thread should stop, because the search as a whole ran
+ * out of nodes or time, or another thread stopped it.
+ */
+static bool search_should_stop(struct halma_search* search) {
+  struct halma_smp* smp = search->smp;
+  unsigned long long uncounted = search->nodes - search->counted;
+  if (uncounted >= search->node_batch) {
+    unsigned long long total = atomic_fetch_add_explicit(
+                                   &smp->nodes, uncounted,
+                                   memory_order_relaxed) +
+                               uncounted;
+    search->counted = search->nodes;
+    if (search->limits->nodes && total >= search->limits->nodes)
+      atomic_store_explicit(&smp->stop, true, memory_order_relaxed);
+  }
+  if (search->limits->deadline && search->nodes % HALMA_CLOCK_CHECK == 0 &&
+      halma_engine_clock() >= search->limits->deadline)
+    atomic_store_explicit(&smp->stop, true, memory_order_relaxed);
+  if (search->limits->stop &&
+      atomic_load_explicit(search->limits->stop, memory_order_relaxed))
+    atomic_store_explicit(&smp->stop, true, memory_order_relaxed);
+  if (atomic_load_explicit(&smp->stop, memory_order_relaxed))
+    search->stopped = true;
+  return search->stopped;
+}
+
+static void reverse_moves(halma_move_T* moves, int count) {
+  for (int i = 0, o = count - 1; i < o; i++, o--) {
+    halma_move_T move = moves[i];
+    moves[i] = moves[o];
+    moves[o] = move;
+  }
+}
+
+/**
+ * @brief Starts every helper thread's root move list at a different move, so
+ * they don't all search the same tree in the same order.
+ */
+static void order_root(struct halma_search* search, halma_move_T* moves,
+                       int count) {
+  int shift = search->id % count;
+  if (shift == 0) return;
+  reverse_moves(moves, shift);
+  reverse_moves(moves + shift, count - shift);
+  reverse_moves(moves, count);
+}
+
+/**
+ * @brief Ordering score of a move, higher is searched sooner.
+ */
+static int move_score(struct halma_search* search, enum halma_piece turn,
+                      int ply, halma_move_T move) {
+  for (int i = 0; i < HALMA_KILLERS; i++)
+    if (search->killers[ply][i] == move) return HALMA_KILLER_SCORE - i;
+  int from = halma_move_from(move), to = halma_move_to(move);
+  int progress = halma_square_distance(&search->board, turn, from) -
+                 halma_square_distance(&search->board, turn, to);
+  return (progress * HALMA_PROGRESS_WEIGHT) +
+         search->history[halma_set_index(turn)][from][to];
+}
+
+enum picker_stage { PICK_TT, PICK_GENERATE, PICK_REST };
+
+/**
+ * @brief Hands out a node's moves best first, in stages. The table's move is
+ * tried before anything is generated, often it's all a node needs. The rest
+ * are scored (see move_score) and only sorted as far as they're asked for, a
+ * cutoff leaves the rest alone.
+ */
+struct move_picker {
+  struct halma_search* search;
+  enum halma_piece turn;
+  int ply;
+  halma_move_T tt_move;  // 0 if there is none, or it isn't legal here
+  enum picker_stage stage;
+  int count;
+  int next;      // moves before this in the list have been handed out
+  int searched;  // moves handed out, including the table's
+};
+
+static void picker_init(struct move_picker* picker,
+                        struct halma_search* search, enum halma_piece turn,
+                        int ply, halma_move_T tt_move) {
+  picker->search = search;
+  picker->turn = turn;
+  picker->ply = ply;
+  // a table entry can belong to another position with the same key
+  if (tt_move && !halma_is_legal_move(&search->board, halma_move_from(tt_move),
+                                      halma_move_to(tt_move)))
+    tt_move = 0;
+  picker->tt_move = tt_move;
+  picker->stage = tt_move ? PICK_TT : PICK_GENERATE;
+  picker->count = picker->next = picker->searched = 0;
+}
+
+/**
+ * @brief Gets the next best move.
+ * @return bool false once every move has been handed out.
+ */
+static bool picker_next(struct move_picker* picker, halma_move_T* move) {
+  struct halma_search* search = picker->search;
+  halma_move_T* moves = search->moves[picker->ply];
+  int* scores = search->scores[picker->ply];
+  if (picker->stage == PICK_TT) {
+    picker->stage = PICK_GENERATE;
+    picker->searched++;
+    *move = picker->tt_move;
+    return true;
+  }
+  if (picker->stage == PICK_GENERATE) {
+    picker->stage = PICK_REST;
+    picker->count = halma_generate_moves(&search->board, picker->turn, moves);
+    // helper threads keep their own order at the root, so they don't all
+    // search the same tree
+    bool rotated = picker->ply == 0 && search->id > 0;
+    if (rotated) order_root(search, moves, picker->count);
+    for (int i = 0; i < picker->count; i++)
+      scores[i] =
+          rotated ? 0 : move_score(search, picker->turn, picker->ply, moves[i]);
+  }
+
+  while (picker->next < picker->count) {
+    int next = picker->next++, best = next;
+    for (int i = next + 1; i < picker->count && next < HALMA_PICK_SORTED; i++)
+      if (scores[i] > scores[best]) best = i;
+    halma_move_T picked = moves[best];
+    int score = scores[best];
+    moves[best] = moves[next];
+    scores[best] = scores[next];
+    moves[next] = picked;
+    scores[next] = score;
+    if (picked == picker->tt_move) continue;  // already searched
+    picker->searched++;
+    *move = picked;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Pulls a history score toward HALMA_HISTORY_MAX (or its negative) by
+ * bonus, the closer it already is the less it moves.
+ */
+static void history_update(struct halma_search* search, enum halma_piece turn,
+                           halma_move_T move, int bonus) {
+  int* history = &search->history[halma_set_index(turn)][halma_move_from(move)]
+                                 [halma_move_to(move)];
+  *history += bonus - (*history * abs(bonus) / HALMA_HISTORY_MAX);
+}
+
+/**
+ * @brief Learns from move causing a cutoff, it becomes a killer and its
+ * history goes up, while the history of every move tried before it goes down.
+ */
+static void search_cutoff(struct halma_search* search,
+                          struct move_picker* picker, int depth,
+                          halma_move_T move) {
+  halma_move_T* killers = search->killers[picker->ply];
+  int bonus = depth * depth;
+  bool first = picker->searched == 1;
+  search->cutoffs++;
+  if (first) search->first_cutoffs++;
+
+  if (killers[0] != move) {
+    for (int i = HALMA_KILLERS - 1; i > 0; i--) killers[i] = killers[i - 1];
+    killers[0] = move;
+  }
+  history_update(search, picker->turn, move, bonus);
+  if (first) return;
+  // the cutoff move is the last one handed out
+  halma_move_T* moves = search->moves[picker->ply];
+  if (picker->tt_move)
+    history_update(search, picker->turn, picker->tt_move, -bonus);
+  for (int i = 0; i < picker->next - 1; i++)
+    if (moves[i] != picker->tt_move)
+      history_update(search, picker->turn, moves[i], -bonus);
+}
+
+static int search_node(struct halma_search* search, int depth, int alpha,
+                       int beta, int ply) {
+  struct halma_board* board = &search->board;
+  enum halma_piece turn = halma_whos_turn(board);
+
+  // the last move might have ended the game
+  enum halma_piece winner = halma_check_victory_all(board);
+  if (winner != EMPTY)
+    return winner == turn ? HALMA_SCORE_WIN - ply : -HALMA_SCORE_WIN + ply;
+  if (depth <= 0 || ply >= HALMA_MAX_PLY - 1)
+    return halma_evaluate(board, turn);
+
+  search->nodes++;
+  if (search_should_stop(search)) return 0;
+
+  bool pv_node = beta - alpha > 1;
+  halma_move_T tt_move = 0;
+  struct halma_tt_entry entry;
+  if (halma_tt_probe(engine_tt, board->hash, &entry, &search->tt)) {
+    tt_move = entry.move;
+    int score = tt_score_from(entry.score, ply);
+    // the root always searches so it has a move to return
+    if (!pv_node && ply > 0 && entry.depth >= depth &&
+        (entry.bound == HALMA_TT_EXACT ||
+         (entry.bound == HALMA_TT_LOWER && score >= beta) ||
+         (entry.bound == HALMA_TT_UPPER && score <= alpha)))
+      return score;
+  }
+
+  // the table's move goes first, it was the best last time
+  struct move_picker picker;
+  halma_move_T move;
+  picker_init(&picker, search, turn, ply, tt_move);
+  if (!picker_next(&picker, &move)) {
+    // nothing to move, the turn is forfeit
+    if (!search_make(search, halma_move(0, 0)))
+      return halma_evaluate(board, turn);
+    int score = -search_node(search, depth - 1, -beta, -alpha, ply + 1);
+    halma_unmake_move(board, &search->undo);
+    return score;
+  }
+
+  int original_alpha = alpha;
+  int best = -HALMA_SCORE_INFINITE;
+  halma_move_T best_move = 0;
+  do {
+    if (!search_make(search, move)) return halma_evaluate(board, turn);
+    int score;
+    if (picker.searched == 1) {
+      score = -search_node(search, depth - 1, -beta, -alpha, ply + 1);
+    } else {
+      // everything after the first move just has to be shown to be worse,
+      // which a null window does cheaply. Only search properly if it isn't.
+      score = -search_node(search, depth - 1, -alpha - 1, -alpha, ply + 1);
+      if (score > alpha && score < beta)
+        score = -search_node(search, depth - 1, -beta, -alpha, ply + 1);
+    }
+    halma_unmake_move(board, &search->undo);
+    if (search->stopped) return 0;
+
+    if (score > best) {
+      best = score;
+      best_move = move;
+      // a root move that fails low is only known to be worse than something,
+      // so it's no use as the best move if the search gets stopped
+      if (score > alpha) {
+        alpha = score;
+        if (ply == 0) search->root_move = best_move;
+      }
+      if (alpha >= beta) {
+        search_cutoff(search, &picker, depth, move);
+        break;
+      }
+    }
+  } while (picker_next(&picker, &move));
+
+  enum halma_tt_bound bound = best >= beta             ? HALMA_TT_LOWER
+                              : best > original_alpha ? HALMA_TT_EXACT
+                                                      : HALMA_TT_UPPER;
+  halma_tt_store(engine_tt, board->hash, tt_score_to(best, ply), depth, bound,
+                 best_move, &search->tt);
+  return best;
+}
+
+/* Paranoid scores are always for the root player, so the same position
+ * searched for different players (or by negamax) has to be kept apart in the
+ * table. Each root player's entries get their own salt.
+ */
+static uint64_t paranoid_key(struct halma_search* search) {
+  uint64_t salt = halma_zobrist_turn[halma_set_index(search->root)];
+  return search->board.hash ^ ((salt << 32) | (salt >> 32));
+}
+
+/**
+ * @brief Plain alpha-beta where the root player maximizes and every other
+ * player minimizes the root player's score.
+ */
+static int search_paranoid(struct halma_search* search, int depth, int alpha,
+                           int beta, int ply) {
+  struct halma_board* board = &search->board;
+  enum halma_piece turn = halma_whos_turn(board);
+  bool maximizing = turn == search->root;
+
+  enum halma_piece winner = halma_check_victory_all(board);
+  if (winner != EMPTY)
+    return winner == search->root ? HALMA_SCORE_WIN - ply
+                                  : -HALMA_SCORE_WIN + ply;
+  if (depth <= 0 || ply >= HALMA_MAX_PLY - 1)
+    return halma_evaluate(board, search->root);
+
+  search->nodes++;
+  if (search_should_stop(search)) return 0;
+
+  uint64_t key = paranoid_key(search);
+  halma_move_T tt_move = 0;
+  struct halma_tt_entry entry;
+  if (halma_tt_probe(engine_tt, key, &entry, &search->tt)) {
+    tt_move = entry.move;
+    int score = tt_score_from(entry.score, ply);
+    if (ply > 0 && entry.depth >= depth &&
+        (entry.bound == HALMA_TT_EXACT ||
+         (entry.bound == HALMA_TT_LOWER && score >= beta) ||
+         (entry.bound == HALMA_TT_UPPER && score <= alpha)))
+      return score;
+  }
+
+  struct move_picker picker;
+  halma_move_T move;
+  picker_init(&picker, search, turn, ply, tt_move);
+  if (!picker_next(&picker, &move)) {
+    if (!search_make(search, halma_move(0, 0)))
+      return halma_evaluate(board, search->root);
+    int score = search_paranoid(search, depth - 1, alpha, beta, ply + 1);
+    halma_unmake_move(board, &search->undo);
+    return score;
+  }
+
+  int original_alpha = alpha, original_beta = beta;
+  int best = maximizing ? -HALMA_SCORE_INFINITE : HALMA_SCORE_INFINITE;
+  halma_move_T best_move = 0;
+  do {
+    if (!search_make(search, move)) return halma_evaluate(board, search->root);
+    int score = search_paranoid(search, depth - 1, alpha, beta, ply + 1);
+    halma_unmake_move(board, &search->undo);
+    if (search->stopped) return 0;
+
+    if (maximizing ? score > best : score < best) {
+      best = score;
+      best_move = move;
+      if (ply == 0) search->root_move = best_move;
+      if (maximizing && score > alpha) alpha = score;
+      if (!maximizing && score < beta) beta = score;
+      if (alpha >= beta) {
+        search_cutoff(search, &picker, depth, move);
+        break;
+      }
+    }
+  } while (picker_next(&picker, &move));
+
+  enum halma_tt_bound bound = best >= original_beta    ? HALMA_TT_LOWER
+                              : best > original_alpha ? HALMA_TT_EXACT
+                                                      : HALMA_TT_UPPER;
+  halma_tt_store(engine_tt, key, tt_score_to(best, ply), depth, bound,
+                 best_move, &search->tt);
+  return best;
+}
+
+/**
+ * @brief Max-n search, fills in scores with what every player ends up with if
+ * each of them picks their best move. bound is the best score the player who
+ * moved into this node already has elsewhere, see enum halma_search_mode.
+ */
+static void search_maxn(struct halma_search* search, int depth, int bound,
+                        int ply, int scores[HALMA_MAX_PLAYERS]) {
+  struct halma_board* board = &search->board;
+  enum halma_piece turn = halma_whos_turn(board);
+  dimension_T player = halma_set_index(turn);
+
+  if (depth <= 0 || ply >= HALMA_MAX_PLY - 1 ||
+      halma_check_victory_all(board) != EMPTY) {
+    halma_evaluate_shares(board, scores);
+    return;
+  }
+
+  search->nodes++;
+  if (search_should_stop(search)) return;
+
+  // there's no table, but the root can still start with the last best move
+  struct move_picker picker;
+  halma_move_T move;
+  picker_init(&picker, search, turn, ply,
+              ply == 0 ? search->last_root_move : 0);
+  if (!picker_next(&picker, &move)) {
+    // a forfeit isn't a choice, so there's nothing to prune against
+    if (!search_make(search, halma_move(0, 0))) {
+      halma_evaluate_shares(board, scores);
+      return;
+    }
+    search_maxn(search, depth - 1, 0, ply + 1, scores);
+    halma_unmake_move(board, &search->undo);
+    return;
+  }
+
+  int child[HALMA_MAX_PLAYERS];
+  scores[player] = -1;
+  do {
+    if (!search_make(search, move)) {
+      halma_evaluate_shares(board, scores);
+      return;
+    }
+    search_maxn(search, depth - 1, scores[player], ply + 1, child);
+    halma_unmake_move(board, &search->undo);
+    if (search->stopped) return;
+
+    if (child[player] > scores[player]) {
+      for (int o = 0; o < HALMA_MAX_PLAYERS; o++) scores[o] = child[o];
+      if (ply == 0) search->root_move = move;
+    }
+    // shares never add up to more than HALMA_SHARE_TOTAL, so whatever is
+    // left over is the most the player before us could get from here
+    if (scores[player] >= HALMA_SHARE_TOTAL - bound) {
+      search_cutoff(search, &picker, depth, move);
+      return;
+    }
+  } while (picker_next(&picker, &move));
+}
+
+/**
+ * @brief Checks if there's time to start another iteration, call it right
+ * after the last one finished. Each iteration takes a lot longer than the one
+ * before it, so one that couldn't finish by the soft deadline isn't started.
+ */
+static bool search_next_iteration(struct halma_search* search, bool first) {
+  double now = halma_engine_clock();
+  double soft_deadline = search->smp->soft_deadline;
+  if (!first && soft_deadline &&
+      now + ((now - search->iteration_start) * HALMA_TIME_GROWTH) >
+          soft_deadline)
+    return false;
+  search->iteration_start = now;
+  return true;
+}
+
+/**
+ * @brief Whatever root move a stopped iteration had settled on is still worth
+ * more than the last iteration's, it's been searched deeper and shown to be at
+ * least as good.
+ */
+static void search_stopped(struct halma_search* search) {
+  if (search->root_move) search->result.move = search->root_move;
+}
+
+/**
+ * @brief Iterative deepening for games with more than 2 players.
+ */
+static void search_multiplayer(struct halma_search* search, int first_depth,
+                               int max_depth) {
+  struct halma_search_result* result = &search->result;
+  for (int depth = first_depth; depth <= max_depth; depth++) {
+    if (!search_next_iteration(search, depth == first_depth)) break;
+    int score;
+    search->root_move = 0;
+    if (search->limits->mode == HALMA_SEARCH_MAXN) {
+      int scores[HALMA_MAX_PLAYERS] = {0};  // left alone if stopped
+      search_maxn(search, depth, 0, 0, scores);
+      score = scores[halma_set_index(search->root)];
+    } else {
+      score = search_paranoid(search, depth, -HALMA_SCORE_INFINITE,
+                              HALMA_SCORE_INFINITE, 0);
+    }
+    if (search->stopped) {
+      search_stopped(search);
+      break;
+    }
+
+    result->move = search->last_root_move = search->root_move;
+    result->score = score;
+    result->depth = depth;
+    if (search->limits->mode == HALMA_SEARCH_PARANOID && is_win_score(score))
+      break;
+  }
+}
+
+/**
+ * @brief Iterative deepening for 2 player games.
+ */
+static void search_two_player(struct halma_search* search, int first_depth,
+                              int max_depth) {
+  struct halma_search_result* result = &search->result;
+  for (int depth = first_depth; depth <= max_depth; depth++) {
+    if (!search_next_iteration(search, depth == first_depth)) break;
+    // start with a narrow window around the last score and widen whichever
+    // side the score fell out of
+    int window = HALMA_ASPIRATION_WINDOW;
+    int alpha = -HALMA_SCORE_INFINITE, beta = HALMA_SCORE_INFINITE;
+    if (depth > 2 && !is_win_score(result->score)) {
+      alpha = result->score - window;
+      beta = result->score + window;
+    }
+    int score;
+    // kept through re-searches, a move that failed high is still good
+    search->root_move = 0;
+    do {
+      score = search_node(search, depth, alpha, beta, 0);
+      if (search->stopped) break;
+      window *= 4;
+      if (score <= alpha)
+        alpha = score - window < -HALMA_SCORE_INFINITE ? -HALMA_SCORE_INFINITE
+                                                      : score - window;
+      else if (score >= beta)
+        beta = score + window > HALMA_SCORE_INFINITE ? HALMA_SCORE_INFINITE
+                                                    : score + window;
+      else
+        break;
+    } while (true);
+    if (search->stopped) {
+      search_stopped(search);
+      break;
+    }
+
+    result->move = search->root_move;
+    result->score = score;
+    result->depth = depth;
+    // nothing left to find once a forced win or loss is in sight
+    if (is_win_score(score)) break;
+  }
+}
+
+/**
+ * @brief Runs one thread's search. Every other helper starts a ply deeper so
+ * the threads spread out over the depths. The whole search is over when the
+ * main thread is done.
+ */
+static void* search_thread_main(void* arg) {
+  struct halma_search* search = arg;
+  const struct halma_limits* limits = search->limits;
+  int max_depth = limits->depth > 0 && limits->depth < HALMA_MAX_PLY - 1
+                      ? limits->depth
+                      : HALMA_MAX_PLY - 1;
+  int first_depth = 1 + search->id % 2;
+  if (first_depth > max_depth) first_depth = max_depth;
+
+  // a move to fall back on if even the first iteration doesn't finish
+  int count = halma_generate_moves(&search->board, search->root,
+                                   search->moves[0]);
+  if (count > 0) {
+    search->result.move = search->moves[0][0];
+    if (search->board.players == 2)
+      search_two_player(search, first_depth, max_depth);
+    else
+      search_multiplayer(search, first_depth, max_depth);
+  }
+
+  if (search->id == 0)
+    atomic_store_explicit(&search->smp->stop, true, memory_order_relaxed);
+  return NULL;
+}
+
+static void search_init(struct halma_search* search, struct halma_smp* smp,
+                        int id, int threads, struct halma_board* board,
+                        const struct halma_limits* limits) {
+  search->smp = smp;
+  search->id = id;
+  search->board = *board;
+  halma_init_undo(&search->undo, search->records, HALMA_MAX_PLY);
+  search->limits = limits;
+  search->root = halma_whos_turn(board);
+  search->nodes = search->counted = 0;
+  // one thread alone keeps an exact count, it's the only one adding to it
+  search->node_batch = threads > 1 ? HALMA_NODE_BATCH : 1;
+  search->stopped = false;
+  search->root_move = search->last_root_move = 0;
+  search->result = (struct halma_search_result){0};
+  memset(search->killers, 0, sizeof(search->killers));
+  memset(search->history, 0, sizeof(search->history));
+  search->cutoffs = search->first_cutoffs = 0;
+  search->tt = (struct halma_tt_stats){0};
+}
+
+static void smp_init(struct halma_smp* smp, double soft_deadline) {
+  smp->soft_deadline = soft_deadline;
+  atomic_init(&smp->stop, false);
+  atomic_init(&smp->nodes, 0);
+}
+
+/**
+ * @brief Runs a search, with every thread it is allowed.
+ * @param soft_deadline no new iterations are started after this, 0 for none.
+ */
+static struct halma_search_result engine_search(
+    struct halma_board* board, const struct halma_limits* limits,
+    double start, double soft_deadline) {
+  if (engine_tt == NULL) engine_tt = halma_tt_create(HALMA_ENGINE_TT_MB);
+  if (!limits->continues) halma_tt_new_search(engine_tt);
+
+  int threads = limits->threads > 1 ? limits->threads : 1;
+  struct halma_smp smp;
+  smp_init(&smp, soft_deadline);
+  struct halma_search* searches = malloc(threads * sizeof(struct halma_search));
+  pthread_t* handles = malloc(threads * sizeof(pthread_t));
+  if (searches == NULL || handles == NULL) exit(EXIT_MALLOC_ERROR);
+
+  for (int i = 0; i < threads; i++)
+    search_init(&searches[i], &smp, i, threads, board, limits);
+  for (int i = 1; i < threads; i++)
+    if (pthread_create(&handles[i], NULL, search_thread_main, &searches[i]))
+      exit(EXIT_THREAD_ERROR);
+  search_thread_main(&searches[0]);
+  for (int i = 1; i < threads; i++) pthread_join(handles[i], NULL);
+
+  // whichever thread got the deepest has the best idea of the best move, the
+  // main thread if it's a tie
+  struct halma_search_result result = searches[0].result;
+  unsigned long long nodes = 0, cutoffs = 0, first_cutoffs = 0;
+  struct halma_tt_stats tt = {0};
+  for (int i = 0; i < threads; i++) {
+    if (searches[i].result.depth > result.depth) result = searches[i].result;
+    nodes += searches[i].nodes;
+    cutoffs += searches[i].cutoffs;
+    first_cutoffs += searches[i].first_cutoffs;
+    tt.probes += searches[i].tt.probes;
+    tt.hits += searches[i].tt.hits;
+    tt.stores += searches[i].tt.stores;
+    tt.replacements += searches[i].tt.replacements;
+  }
+  result.nodes = nodes;
+  result.cutoffs = cutoffs;
+  result.first_cutoffs = first_cutoffs;
+  result.tt = tt;
+  result.tt_permille = halma_tt_permille(engine_tt);
+  result.threads = threads;
+  result.seconds = halma_engine_clock() - start;
+
+  free(handles);
+  free(searches);
+  return result;
+}
+
+struct halma_search_result halma_engine_best_move(
+    struct halma_board* board, const struct halma_limits* limits) {
+  return engine_search(board, limits, halma_engine_clock(), 0);
+}
+
+/**
+ * @brief How much of a timed move's budget to spend starting iterations. The
+ * opening is mostly getting pieces out of the camp and the endgame mostly
+ * races the search sees the end of quickly, the middle of the game is where
+ * more time pays off.
+ */
+static double engine_time_share(struct halma_board* board) {
+  // how far along the game is, 0 at the start and 1 once everyone is home
+  int start = 0, now = 0;
+  for (int set = 0; set < board->players; set++) {
+    bitboard_T camp = halma_camp_sets[halma_variant(board)][set];
+    while (bitboard_any(camp))
+      start +=
+          halma_square_distance(board, set + 1, bitboard_pop_first(&camp));
+    now += halma_distance_to_goal(board, set + 1);
+  }
+  double progress = start ? 1 - ((double)now / start) : 1;
+  if (progress < 0) progress = 0;
+  return HALMA_TIME_SHARE_EDGES + ((HALMA_TIME_SHARE_MIDDLE -
+                                    HALMA_TIME_SHARE_EDGES) *
+                                   4 * progress * (1 - progress));
+}
+
+struct halma_search_result halma_engine_timed_move(
+    struct halma_board* board, const struct halma_limits* limits,
+    double seconds) {
+  double start = halma_engine_clock();
+  struct halma_limits timed = *limits;
+  double reserve = seconds > 2 * HALMA_TIME_RESERVE ? HALMA_TIME_RESERVE
+                                                    : seconds / 2;
+  double deadline = start + seconds - reserve;
+  if (timed.deadline == 0 || deadline < timed.deadline)
+    timed.deadline = deadline;
+  double soft_deadline =
+      start + ((timed.deadline - start) * engine_time_share(board));
+  return engine_search(board, &timed, start, soft_deadline);
+}
+
+/**
+ * @brief Adds a move to a ranking, keeping it in order. If the ranking is full
+ * the worst move drops off, so the new one has to be better than it.
+ */
+static void rank_insert(struct halma_ranking* ranking, halma_move_T move,
+                        int score) {
+  int i = ranking->count < HALMA_RANKED_MOVES ? ranking->count++
+                                              : HALMA_RANKED_MOVES - 1;
+  for (; i > 0 && ranking->scores[i - 1] < score; i--) {
+    ranking->moves[i] = ranking->moves[i - 1];
+    ranking->scores[i] = ranking->scores[i - 1];
+  }
+  ranking->moves[i] = move;
+  ranking->scores[i] = score;
+}
+
+struct halma_ranking halma_engine_rank_moves(
+    struct halma_board* board, const struct halma_limits* limits,
+    void (*ranked)(const struct halma_ranking* ranking, void* arg),
+    void* arg) {
+  struct halma_ranking ranking = {0};
+  if (engine_tt == NULL) engine_tt = halma_tt_create(HALMA_ENGINE_TT_MB);
+  if (!limits->continues) halma_tt_new_search(engine_tt);
+
+  struct halma_smp smp;
+  smp_init(&smp, 0);
+  struct halma_search* search = malloc(sizeof(struct halma_search));
+  if (search == NULL) exit(EXIT_MALLOC_ERROR);
+  search_init(search, &smp, 0, 1, board, limits);
+  halma_move_T* moves = search->moves[0];
+  int count = halma_generate_moves(&search->board, search->root, moves);
+  int max_depth = limits->depth > 0 && limits->depth < HALMA_MAX_PLY - 1
+                      ? limits->depth
+                      : HALMA_MAX_PLY - 1;
+
+  for (int depth = 1; depth <= max_depth && count > 0; depth++) {
+    struct halma_ranking current = {0};
+    // the last depth's best moves go first, they set a high bar for the rest
+    for (int o = 0; o < ranking.count; o++)
+      for (int i = o; i < count; i++)
+        if (moves[i] == ranking.moves[o]) {
+          moves[i] = moves[o];
+          moves[o] = ranking.moves[o];
+          break;
+        }
+
+    for (int i = 0; i < count; i++) {
+      // only moves that could make the cut need an exact score
+      int alpha = current.count == HALMA_RANKED_MOVES
+                      ? current.scores[HALMA_RANKED_MOVES - 1]
+                      : -HALMA_SCORE_INFINITE;
+      int score;
+      if (!search_make(search, moves[i])) {
+        score = halma_evaluate(&search->board, search->root);
+      } else {
+        score = board->players == 2
+                    ? -search_node(search, depth - 1, -HALMA_SCORE_INFINITE,
+                                   -alpha, 1)
+                    : search_paranoid(search, depth - 1, alpha,
+                                      HALMA_SCORE_INFINITE, 1);
+        halma_unmake_move(&search->board, &search->undo);
+      }
+      if (search->stopped) break;
+      if (score > alpha) rank_insert(&current, moves[i], score);
+    }
+    if (search->stopped) break;
+
+    current.depth = depth;
+    ranking = current;
+    if (ranked != NULL) ranked(&ranking, arg);
+    if (is_win_score(ranking.scores[0])) break;
+  }
+
+  free(search);
+  return ranking;
+}
+
+void halma_engine_new_game() {
+  // made here so the first move doesn't pay for it
+  if (engine_tt == NULL)
+    engine_tt = halma_tt_create(HALMA_ENGINE_TT_MB);
+  else
+    halma_tt_clear(engine_tt);
+}
@@ -0,0 +1,145 @@
+#ifndef HALMA_ENGINE_H_INCLUDED
+#define HALMA_ENGINE_H_INCLUDED
+/* halma_engine.h
+ * Computer player. Picks moves for 2 player games with an iterative deepening
+ * alpha-beta (negamax) search, using aspiration windows, principal variation
+ * search and a transposition table shared between calls. 4 player games are
+ * searched with either paranoid or max-n search, see enum halma_search_mode.
+ * Searches can use more than one thread (Lazy SMP): every thread searches the
+ * same position on its own, and they help each other through the table.
+ */
+#include <stdatomic.h>
+
+#include "halma.h"
+#include "halma_tt.h"
+
+// deepest the search will ever go
+#define HALMA_MAX_PLY 64
+
+/**
+ * @brief How to search games with more than 2 players, 2 player games always
+ * use alpha-beta.
+ * Paranoid search assumes everybody else is only out to stop the player
+ * searching, which turns the game back into 2 sides and allows full alpha-beta
+ * pruning.
+ * Max-n keeps a score for every player and assumes each of them picks what is
+ * best for themselves. It can only cut off a move when a player's share is so
+ * big the player before them couldn't possibly prefer it (shallow pruning), so
+ * it doesn't get as deep.
+ */
+enum halma_search_mode { HALMA_SEARCH_PARANOID = 0, HALMA_SEARCH_MAXN };
+
+/**
+ * @brief How much searching to do. A 0 means no limit, but at least one of
+ * depth, nodes and deadline should be set or the search will run to
+ * HALMA_MAX_PLY. nodes counts every thread's nodes together. Whichever limit
+ * is hit first stops the search.
+ */
+struct halma_limits {
+  int depth;
+  unsigned long long nodes;
+  enum halma_search_mode mode;
+  int threads;      // threads to search with, 0 is the same as 1
+  double deadline;  // halma_engine_clock() time to stop by
+  atomic_bool* stop;  // another thread can set this to stop the search
+  // carries on from the last search (like pondering the reply to a move just
+  // ranked), so what it stored in the table isn't aged
+  bool continues;
+};
+
+/**
+ * @brief What a search found.
+ */
+struct halma_search_result {
+  halma_move_T move;  // best move, from == to if the only option is passing
+  int score;          // for the side to move, see halma_eval.h
+  int depth;          // deepest fully searched depth
+  unsigned long long nodes;  // every thread's nodes together
+  int threads;
+  double seconds;  // wall clock time the search took, nodes / seconds /
+                   // threads is the nodes per second of each thread
+  unsigned long long cutoffs;
+  unsigned long long first_cutoffs;  // cutoffs by the first move searched,
+                                     // the more the better moves are ordered
+  struct halma_tt_stats tt;  // every thread's table use together
+  int tt_permille;           // how full the table was after the search
+};
+
+// how many moves halma_engine_rank_moves ranks
+#define HALMA_RANKED_MOVES 3
+
+/**
+ * @brief The best few moves in a position, best first.
+ */
+struct halma_ranking {
+  int count;
+  int depth;  // how deep the moves were searched
+  halma_move_T moves[HALMA_RANKED_MOVES];
+  int scores[HALMA_RANKED_MOVES];  // for the side to move, see halma_eval.h
+};
+
+/**
+ * @brief Seconds since some fixed point in the past, for setting deadlines.
+ * Never goes backwards.
+ */
+double halma_engine_clock();
+
+/**
+ * @brief Searches for the best move for whoever's turn it is. The board is
+ * not changed. A search stopped part way through an iteration still returns
+ * the best move it has found, which can come from the unfinished iteration.
+ *
+ * @param board the current game board.
+ * @param limits how much searching to do.
+ * @return struct halma_search_result the move and some stats about the
+ * search.
+ */
+struct halma_search_result halma_engine_best_move(
+    struct halma_board* board, const struct halma_limits* limits);
+
+/**
+ * @brief Searches for a move for whoever's turn it is within a time budget,
+ * for playing games. Always returns within seconds, give or take a fraction of
+ * a millisecond. How much of the budget is spent depends on how far the game
+ * is along: in the opening and endgame no iteration is started that isn't
+ * expected to finish within 40% of it, the middle of the game can use all of
+ * it.
+ *
+ * @param board the current game board.
+ * @param limits any other limits, an earlier deadline than the budget's
+ * overrides it.
+ * @param seconds the time budget for this move.
+ * @return struct halma_search_result the move and some stats about the
+ * search.
+ */
+struct halma_search_result halma_engine_timed_move(
+    struct halma_board* board, const struct halma_limits* limits,
+    double seconds);
+
+/**
+ * @brief Searches for the best few moves for whoever's turn it is, scoring
+ * each of them properly instead of just showing the rest are worse. Always
+ * searched with one thread, 4 player games are scored like paranoid search
+ * whatever limits->mode is.
+ *
+ * @param board the current game board, not changed.
+ * @param limits how much searching to do.
+ * @param ranked if not NULL, called with arg and the ranking every time a
+ * depth is finished, so a caller can use it while deeper ones are searched.
+ * @param arg passed on to ranked.
+ * @return struct halma_ranking the moves from the deepest depth every move
+ * was searched to. Depth 1 is always finished, it only scores the moves
+ * themselves, so count is only 0 if there are no moves.
+ */
+struct halma_ranking halma_engine_rank_moves(
+    struct halma_board* board, const struct halma_limits* limits,
+    void (*ranked)(const struct halma_ranking* ranking, void* arg),
+    void* arg);
+
+/**
+ * @brief Forgets everything learned in earlier searches, call it when
+ * starting a new game.
+ */
+void halma_engine_new_game();
+
+#endif  // HALMA_ENGINE_H_INCLUDED
@@ -0,0 +1,63 @@
+#include "halma_eval.h"
+
+#ifdef HALMA_NNUE
+#include "halma_nnue.h"
+#endif
+
+// how much the squared distances of a set's pieces vary from their average
+// before it costs a tile of distance. Pieces left far behind have to be
+// fetched later, usually without anything to jump over.
+#define HALMA_STRAGGLER_SPREAD 8
+// most a piece still in its starting camp costs, in tiles of distance. It
+// costs nothing while the rest of its set is at home too and all of this once
+// they've all left.
+#define HALMA_HOME_COST 4
+
+/**
+ * @brief How far set is from winning, its distance to goal plus what its
+ * stragglers and pieces left at home cost.
+ */
+static int eval_remaining(struct halma_board* board, dimension_T set) {
+  int pieces = board->player_pieces;
+  int distance = board->distance[set];
+  int home = board->at_home[set];
+  // pieces squared times the variance of the distances
+  int spread = (pieces * board->distance_squared[set]) - (distance * distance);
+  return distance + (spread / (pieces * pieces * HALMA_STRAGGLER_SPREAD)) +
+         (home * (pieces - home) * HALMA_HOME_COST / pieces);
+}
+
+int halma_evaluate(struct halma_board* board, enum halma_piece set) {
+#ifdef HALMA_NNUE
+  if (halma_nnue_loaded()) return halma_nnue_evaluate(board, set);
+#endif
+  int others = 0;
+  for (dimension_T i = 0; i < board->players; i++)
+    if (i != halma_set_index(set)) others += eval_remaining(board, i);
+  return (others / (board->players - 1)) -
+         eval_remaining(board, halma_set_index(set));
+}
+
+void halma_evaluate_shares(struct halma_board* board,
+                           int shares[HALMA_MAX_PLAYERS]) {
+  // the furthest a piece can be from being done
+  const int farthest = 2 * (HALMA_SQUARE_ROOT - 1);
+  enum halma_piece winner = halma_check_victory_all(board);
+  int total = 0;
+  if (winner != EMPTY) {
+    for (dimension_T i = 0; i < HALMA_MAX_PLAYERS; i++) shares[i] = 0;
+    shares[halma_set_index(winner)] = HALMA_SHARE_TOTAL;
+    return;
+  }
+  for (dimension_T i = 0; i < HALMA_MAX_PLAYERS; i++) {
+    shares[i] = 0;
+    if (i >= board->players) continue;
+    shares[i] =
+        (board->player_pieces * farthest) - eval_remaining(board, i);
+    if (shares[i] < 0) shares[i] = 0;
+    total += shares[i];
+  }
+  for (dimension_T i = 0; i < board->players; i++)
+    shares[i] = total ? (shares[i] * HALMA_SHARE_TOTAL) / total
+                      : HALMA_SHARE_TOTAL / board->players;
+}
@@ -0,0 +1,70 @@
+#ifndef HALMA_EVAL_H_INCLUDED
+#define HALMA_EVAL_H_INCLUDED
+/* halma_eval.h
+ * Static evaluation of a board for the search engines. Scores are in the
+ * same units as tiles of distance, bigger is better for whoever the score is
+ * for. Everything is worked out from sums the board keeps up to date as
+ * pieces move, so evaluating doesn't look at the pieces at all.
+ */
+#include "halma.h"
+#include "halma_tables.h"
+
+// score for having won, searches count down from it by the number of moves
+// it took so quicker wins score higher. Nothing else gets close to it.
+#define HALMA_SCORE_WIN 30000
+#define HALMA_SCORE_INFINITE 32000
+
+/**
+ * @brief How far a piece of set on square is from being done, in steps along
+ * the rows and columns, see halma_goal_distances.
+ */
+static inline int halma_square_distance(struct halma_board* board,
+                                        enum halma_piece set, int square) {
+  return halma_goal_distances[halma_variant(board)][halma_set_index(set)]
+                             [square];
+}
+
+/**
+ * @brief How far every piece of a set still has to go, added up (see
+ * halma_square_distance), so a set sitting in its goal is close to 0.
+ *
+ * @param board the board to look at.
+ * @param set the player/set to measure.
+ * @return int total distance.
+ */
+static inline int halma_distance_to_goal(struct halma_board* board,
+                                         enum halma_piece set) {
+  return board->distance[halma_set_index(set)];
+}
+
+/**
+ * @brief Scores the board for one set, how much further along it is than the
+ * other sets in the game (on average, in a 4 player game). How far along a
+ * set is counts the distance its pieces still have to go, with extra for
+ * pieces lagging far behind the rest and for pieces still sitting at home
+ * after the others have left. Builds with a neural network loaded use that
+ * instead, see halma_nnue.h.
+ *
+ * @param board the board to score.
+ * @param set the player/set to score it for.
+ * @return int the score, positive if set is ahead.
+ */
+int halma_evaluate(struct halma_board* board, enum halma_piece set);
+
+// what the shares from halma_evaluate_shares add up to
+#define HALMA_SHARE_TOTAL 1000
+
+/**
+ * @brief Scores the board for every set at once, for searches that keep a
+ * separate score for each player. Each set gets a share of HALMA_SHARE_TOTAL
+ * in proportion to how far along it is, so no score is below 0 and they never
+ * add up to more than HALMA_SHARE_TOTAL. A set that has won gets all of it.
+ *
+ * @param board the board to score.
+ * @param shares filled in with the scores, [halma_set_index(set)]. Sets that
+ * aren't playing get 0.
+ */
+void halma_evaluate_shares(struct halma_board* board,
+                           int shares[HALMA_MAX_PLAYERS]);
+
+#endif  // HALMA_EVAL_H_INCLUDED
@@ -0,0 +1,404 @@
+#include "halma_mcts.h"
+
+#include <math.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "halma_eval.h"
+#include "halma_playout.h"
+
+#define EXIT_MALLOC_ERROR 39
+#define EXIT_THREAD_ERROR 40
+
+#define MCTS_DEFAULT_NODES (1 << 20)
+#define MCTS_EXPLORATION_UCT 0.5
+#define MCTS_EXPLORATION_PUCT 1.5
+// deepest a single iteration goes into the tree
+#define MCTS_MAX_DEPTH 128
+
+enum mcts_state { NODE_LEAF = 0, NODE_EXPANDING, NODE_EXPANDED };
+
+/* A node is a move and what came of it. Children of a node are next to each
+ * other in the pool. The statistics are updated by every thread at once, the
+ * children are written once by whichever thread expands the node and only
+ * read after it has published them by setting state to NODE_EXPANDED.
+ */
+struct mcts_node {
+  _Atomic unsigned long long value;  // shares the mover got, added up
+  _Atomic unsigned int visits;
+  _Atomic unsigned int virtual_loss;  // iterations currently passing through
+  _Atomic unsigned char state;        // enum mcts_state
+  unsigned char mover;  // halma_set_index of who made the move
+  unsigned short child_count;
+  unsigned int first_child;
+  float prior;
+  halma_move_T move;
+};
+
+/**
+ * @brief Everything one worker thread needs for itself.
+ */
+struct mcts_worker {
+  struct halma_mcts* mcts;
+  struct halma_rng rng;
+  struct halma_board board;
+  struct halma_undo records[MCTS_MAX_DEPTH];
+  struct halma_undo_stack undo;
+  unsigned int path[MCTS_MAX_DEPTH + 1];
+  halma_move_T moves[HALMA_MAX_MOVES];
+  unsigned long long iterations;  // run by this worker in the current search
+};
+
+struct halma_mcts {
+  struct halma_mcts_config config;
+  struct mcts_node* nodes;
+  _Atomic size_t used;
+  unsigned int root;
+  struct halma_board root_board;  // the position the root node is for
+  bool has_tree;
+
+  // the current search, read by every worker
+  unsigned long long iteration_limit;
+  double deadline;  // 0 for none
+  _Atomic unsigned long long iterations;
+  _Atomic int max_depth;
+
+  // worker pool, everything below is protected by lock
+  pthread_t* threads;
+  struct mcts_worker* workers;
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation;  // bumped to start every search
+  int running;
+  bool quit;
+};
+
+static void mcts_init_node(struct mcts_node* node, halma_move_T move,
+                           unsigned char mover, float prior) {
+  atomic_init(&node->value, 0);
+  atomic_init(&node->visits, 0);
+  atomic_init(&node->virtual_loss, 0);
+  atomic_init(&node->state, NODE_LEAF);
+  node->mover = mover;
+  node->child_count = 0;
+  node->first_child = 0;
+  node->prior = prior;
+  node->move = move;
+}
+
+/**
+ * @brief Gives a node its children, one for every legal move (or a single
+ * pass if there are none). Only one thread gets to expand each node.
+ * @return true if this thread expanded the node.
+ */
+static bool mcts_expand(struct mcts_worker* worker, struct mcts_node* node) {
+  struct halma_mcts* mcts = worker->mcts;
+  unsigned char expected = NODE_LEAF;
+  if (!atomic_compare_exchange_strong(&node->state, &expected,
+                                      NODE_EXPANDING))
+    return false;
+
+  enum halma_piece turn = halma_whos_turn(&worker->board);
+  int count = halma_generate_moves(&worker->board, turn, worker->moves);
+  if (count == 0) worker->moves[count++] = halma_move(0, 0);
+
+  size_t first = atomic_fetch_add(&mcts->used, count);
+  if (first + count > mcts->config.max_nodes) {
+    // out of nodes, the tree just stops growing here
+    atomic_store(&node->state, NODE_LEAF);
+    return false;
+  }
+
+  // moves that get a piece closer to its goal are tried first
+  float total = 0;
+  float weights[HALMA_MAX_MOVES];
+  for (int i = 0; i < count; i++) {
+    int from = halma_move_from(worker->moves[i]);
+    int to = halma_move_to(worker->moves[i]);
+    int gain = halma_square_distance(&worker->board, turn, from) -
+               halma_square_distance(&worker->board, turn, to);
+    weights[i] = gain > -2 ? gain + 3 : 1;
+    total += weights[i];
+  }
+  for (int i = 0; i < count; i++)
+    mcts_init_node(&mcts->nodes[first + i], worker->moves[i],
+                   halma_set_index(turn), weights[i] / total);
+
+  node->first_child = first;
+  node->child_count = count;
+  atomic_store_explicit(&node->state, NODE_EXPANDED, memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Picks which child of an expanded node to go down, and marks it with
+ * a virtual loss so other threads are steered elsewhere until this iteration
+ * is backed up.
+ */
+static struct mcts_node* mcts_select(struct halma_mcts* mcts,
+                                     struct mcts_node* node) {
+  struct mcts_node* children = &mcts->nodes[node->first_child];
+  double parent = atomic_load_explicit(&node->visits, memory_order_relaxed) +
+                  atomic_load_explicit(&node->virtual_loss,
+                                       memory_order_relaxed) +
+                  1;
+  double sqrt_parent = sqrt(parent), log_parent = log(parent);
+  struct mcts_node* best = children;
+  double best_score = -HUGE_VAL;
+
+  for (int i = 0; i < node->child_count; i++) {
+    struct mcts_node* child = &children[i];
+    // a virtual loss counts as a visit that got nothing
+    double visits =
+        atomic_load_explicit(&child->visits, memory_order_relaxed) +
+        atomic_load_explicit(&child->virtual_loss, memory_order_relaxed);
+    double value = atomic_load_explicit(&child->value, memory_order_relaxed);
+    double mean = visits > 0 ? value / (visits * HALMA_SHARE_TOTAL) : 0;
+    double score;
+    if (mcts->config.puct)
+      score = mean + (mcts->config.exploration * child->prior * sqrt_parent /
+                      (1 + visits));
+    else if (visits == 0)
+      score = HUGE_VAL;  // try everything once, in order of prior
+    else
+      score = mean + (mcts->config.exploration * sqrt(log_parent / visits));
+    if (score > best_score ||
+        (score == best_score && child->prior > best->prior)) {
+      best_score = score;
+      best = child;
+    }
+  }
+
+  atomic_fetch_add_explicit(&best->virtual_loss, 1, memory_order_relaxed);
+  return best;
+}
+
+/**
+ * @brief One iteration: go down the tree to a leaf, expand it, score it and
+ * add the score to every node on the way.
+ */
+static void mcts_iterate(struct mcts_worker* worker) {
+  struct halma_mcts* mcts = worker->mcts;
+  struct halma_board* board = &worker->board;
+  int depth = 0;
+  *board = mcts->root_board;
+  halma_init_undo(&worker->undo, worker->records, MCTS_MAX_DEPTH);
+  worker->path[0] = mcts->root;
+
+  while (depth < MCTS_MAX_DEPTH && halma_check_victory_all(board) == EMPTY) {
+    struct mcts_node* node = &mcts->nodes[worker->path[depth]];
+    if (atomic_load_explicit(&node->state, memory_order_acquire) !=
+        NODE_EXPANDED) {
+      mcts_expand(worker, node);
+      break;
+    }
+    struct mcts_node* child = mcts_select(mcts, node);
+    if (halma_make_move(board, &worker->undo, halma_move_from(child->move),
+                        halma_move_to(child->move)) != 0) {
+      // the game ran out of turns, it's scored where it stands
+      atomic_fetch_sub_explicit(&child->virtual_loss, 1, memory_order_relaxed);
+      break;
+    }
+    worker->path[++depth] = child - mcts->nodes;
+  }
+
+  // a playout that gets stopped before anyone wins is scored where it stopped
+  int shares[HALMA_MAX_PLAYERS];
+  if (mcts->config.playouts && halma_check_victory_all(board) == EMPTY)
+    halma_playout(board, &worker->rng, HALMA_PLAYOUT_MAX_PLIES);
+  halma_evaluate_shares(board, shares);
+
+  for (int i = depth; i >= 0; i--) {
+    struct mcts_node* node = &mcts->nodes[worker->path[i]];
+    atomic_fetch_add_explicit(&node->visits, 1, memory_order_relaxed);
+    if (i == 0) continue;
+    atomic_fetch_add_explicit(&node->value, shares[node->mover],
+                              memory_order_relaxed);
+    atomic_fetch_sub_explicit(&node->virtual_loss, 1, memory_order_relaxed);
+  }
+
+  int deepest = atomic_load_explicit(&mcts->max_depth, memory_order_relaxed);
+  while (depth > deepest && !atomic_compare_exchange_weak(&mcts->max_depth,
+                                                          &deepest, depth))
+    ;
+}
+
+static void* mcts_worker_main(void* arg) {
+  struct mcts_worker* worker = arg;
+  struct halma_mcts* mcts = worker->mcts;
+  unsigned long seen = 0;
+
+  pthread_mutex_lock(&mcts->lock);
+  while (true) {
+    while (mcts->generation == seen && !mcts->quit)
+      pthread_cond_wait(&mcts->start, &mcts->lock);
+    if (mcts->quit) break;
+    seen = mcts->generation;
+    pthread_mutex_unlock(&mcts->lock);
+
+    // an iteration takes long enough that checking the clock every time
+    // costs next to nothing
+    worker->iterations = 0;
+    while (atomic_fetch_add(&mcts->iterations, 1) < mcts->iteration_limit &&
+           (mcts->deadline == 0 || halma_engine_clock() < mcts->deadline)) {
+      mcts_iterate(worker);
+      worker->iterations++;
+    }
+
+    pthread_mutex_lock(&mcts->lock);
+    if (--mcts->running == 0) pthread_cond_signal(&mcts->done);
+  }
+  pthread_mutex_unlock(&mcts->lock);
+  return NULL;
+}
+
+struct halma_mcts* halma_mcts_create(const struct halma_mcts_config* config) {
+  struct halma_mcts* mcts = malloc(sizeof(struct halma_mcts));
+  if (mcts == NULL) exit(EXIT_MALLOC_ERROR);
+  mcts->config = *config;
+  if (mcts->config.threads <= 0)
+    mcts->config.threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (mcts->config.threads <= 0) mcts->config.threads = 1;
+  if (mcts->config.max_nodes == 0) mcts->config.max_nodes = MCTS_DEFAULT_NODES;
+  if (mcts->config.exploration <= 0)
+    mcts->config.exploration =
+        config->puct ? MCTS_EXPLORATION_PUCT : MCTS_EXPLORATION_UCT;
+
+  mcts->nodes = malloc(mcts->config.max_nodes * sizeof(struct mcts_node));
+  if (mcts->nodes == NULL) exit(EXIT_MALLOC_ERROR);
+  atomic_init(&mcts->used, 0);
+  atomic_init(&mcts->iterations, 0);
+  atomic_init(&mcts->max_depth, 0);
+  mcts->has_tree = false;
+
+  pthread_mutex_init(&mcts->lock, NULL);
+  pthread_cond_init(&mcts->start, NULL);
+  pthread_cond_init(&mcts->done, NULL);
+  mcts->generation = 0;
+  mcts->running = 0;
+  mcts->quit = false;
+  mcts->threads = malloc(mcts->config.threads * sizeof(pthread_t));
+  mcts->workers = malloc(mcts->config.threads * sizeof(struct mcts_worker));
+  if (mcts->threads == NULL || mcts->workers == NULL)
+    exit(EXIT_MALLOC_ERROR);
+  for (int i = 0; i < mcts->config.threads; i++) {
+    mcts->workers[i].mcts = mcts;
+    halma_rng_seed(&mcts->workers[i].rng, i);
+    if (pthread_create(&mcts->threads[i], NULL, mcts_worker_main,
+                       &mcts->workers[i]))
+      exit(EXIT_THREAD_ERROR);
+  }
+  return mcts;
+}
+
+/**
+ * @brief Looks through the tree below index, at most depth moves down, for a
+ * node that is the same position as board. board_at is the position at index
+ * and is left as it was.
+ * @return the node's index, -1 if there isn't one.
+ */
+static long mcts_find_position(struct halma_mcts* mcts,
+                               struct halma_board* board,
+                               struct halma_board* board_at,
+                               struct halma_undo_stack* undo, long index,
+                               int depth) {
+  struct mcts_node* node = &mcts->nodes[index];
+  if (board_at->hash == board->hash) return index;
+  if (depth == 0 || atomic_load(&node->state) != NODE_EXPANDED) return -1;
+  for (int i = 0; i < node->child_count; i++) {
+    struct mcts_node* child = &mcts->nodes[node->first_child + i];
+    if (halma_make_move(board_at, undo, halma_move_from(child->move),
+                        halma_move_to(child->move)) != 0)
+      continue;
+    long found = mcts_find_position(mcts, board, board_at, undo,
+                                    node->first_child + i, depth - 1);
+    halma_unmake_move(board_at, undo);
+    if (found >= 0) return found;
+  }
+  return -1;
+}
+
+/**
+ * @brief Gets the tree ready to search board, keeping the part of it that's
+ * still useful if there is one.
+ */
+static void mcts_set_root(struct halma_mcts* mcts, struct halma_board* board) {
+  long found = -1;
+  // only worth keeping if there is room left to grow it
+  if (mcts->has_tree && atomic_load(&mcts->used) < mcts->config.max_nodes / 2) {
+    struct halma_undo records[HALMA_MAX_PLAYERS];
+    struct halma_undo_stack undo;
+    halma_init_undo(&undo, records, HALMA_MAX_PLAYERS);
+    // our move, then one move for everyone else
+    found = mcts_find_position(mcts, board, &mcts->root_board, &undo,
+                               mcts->root, board->players);
+  }
+  if (found < 0) {
+    mcts_init_node(&mcts->nodes[0], 0, 0, 1);
+    atomic_store(&mcts->used, 1);
+    found = 0;
+  }
+  mcts->root = found;
+  mcts->root_board = *board;
+  mcts->has_tree = true;
+}
+
+struct halma_search_result halma_mcts_best_move(
+    struct halma_mcts* mcts, struct halma_board* board,
+    const struct halma_mcts_limits* limits) {
+  struct halma_search_result result = {0};
+  double start = halma_engine_clock();
+  mcts_set_root(mcts, board);
+
+  pthread_mutex_lock(&mcts->lock);
+  mcts->iteration_limit = limits->iterations ? limits->iterations : ULLONG_MAX;
+  mcts->deadline = limits->deadline;
+  atomic_store(&mcts->iterations, 0);
+  atomic_store(&mcts->max_depth, 0);
+  mcts->running = mcts->config.threads;
+  mcts->generation++;
+  pthread_cond_broadcast(&mcts->start);
+  while (mcts->running > 0) pthread_cond_wait(&mcts->done, &mcts->lock);
+  for (int i = 0; i < mcts->config.threads; i++)
+    result.nodes += mcts->workers[i].iterations;
+  pthread_mutex_unlock(&mcts->lock);
+
+  struct mcts_node* root = &mcts->nodes[mcts->root];
+  if (atomic_load(&root->state) == NODE_EXPANDED) {
+    struct mcts_node* best = &mcts->nodes[root->first_child];
+    for (int i = 1; i < root->child_count; i++)
+      if (atomic_load(&mcts->nodes[root->first_child + i].visits) >
+          atomic_load(&best->visits))
+        best = &mcts->nodes[root->first_child + i];
+    result.move = best->move;
+    if (atomic_load(&best->visits))
+      result.score = atomic_load(&best->value) / atomic_load(&best->visits);
+  }
+  result.depth = atomic_load(&mcts->max_depth);
+  result.threads = mcts->config.threads;
+  result.seconds = halma_engine_clock() - start;
+  return result;
+}
+
+void halma_mcts_clear(struct halma_mcts* mcts) { mcts->has_tree = false; }
+
+void halma_mcts_destroy(struct halma_mcts* mcts) {
+  pthread_mutex_lock(&mcts->lock);
+  mcts->quit = true;
+  pthread_cond_broadcast(&mcts->start);
+  pthread_mutex_unlock(&mcts->lock);
+  for (int i = 0; i < mcts->config.threads; i++)
+    pthread_join(mcts->threads[i], NULL);
+
+  pthread_mutex_destroy(&mcts->lock);
+  pthread_cond_destroy(&mcts->start);
+  pthread_cond_destroy(&mcts->done);
+  free(mcts->threads);
+  free(mcts->workers);
+  free(mcts->nodes);
+  free(mcts);
+}
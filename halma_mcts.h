@@ -0,0 +1,74 @@
+#ifndef HALMA_MCTS_H_INCLUDED
+#define HALMA_MCTS_H_INCLUDED
+/* halma_mcts.h
+ * Monte Carlo tree search. A pool of worker threads grows one shared tree,
+ * every node's statistics are updated with atomics so no locks are taken
+ * while searching. Works for 2 and 4 player games, each node is scored for
+ * the player who made the move leading to it.
+ */
+#include <stddef.h>
+
+#include "halma.h"
+#include "halma_engine.h"
+
+/**
+ * @brief Settings for a search tree, fixed when it is created.
+ */
+struct halma_mcts_config {
+  int threads;        // worker threads, 0 for one per core
+  size_t max_nodes;   // size of the node pool, the tree stops growing when
+                      // it runs out
+  bool puct;          // PUCT selection using move priors instead of UCT
+  double exploration; // how much to favor less visited moves, 0 for default
+  bool playouts;      // score leaves by playing the game out (see
+                      // halma_playout.h) instead of with halma_evaluate_shares
+};
+
+/**
+ * @brief How much searching to do for one move. A 0 means no limit, but one of
+ * them has to be set. Whichever is hit first stops the search.
+ */
+struct halma_mcts_limits {
+  unsigned long long iterations;  // total for all threads together
+  double deadline;                // halma_engine_clock() time to stop by
+};
+
+struct halma_mcts;
+
+/**
+ * @brief Allocates a search tree and starts its worker threads, they sleep
+ * until a search is started.
+ *
+ * @param config settings for the tree.
+ * @return struct halma_mcts* the tree, on the heap.
+ */
+struct halma_mcts* halma_mcts_create(const struct halma_mcts_config* config);
+
+/**
+ * @brief Searches for the best move for whoever's turn it is. If the board is
+ * a position the tree already searched (after our last move and the other
+ * players' replies) that part of the tree is kept and searched further,
+ * otherwise the tree is started over.
+ *
+ * @param mcts the search tree.
+ * @param board the current game board, not changed.
+ * @param limits how much searching to do.
+ * @return struct halma_search_result the most visited move. score is its
+ * average share of HALMA_SHARE_TOTAL (see halma_eval.h), depth the deepest
+ * the tree got and nodes the number of iterations every thread ran together.
+ */
+struct halma_search_result halma_mcts_best_move(
+    struct halma_mcts* mcts, struct halma_board* board,
+    const struct halma_mcts_limits* limits);
+
+/**
+ * @brief Throws the whole tree away, call it when starting a new game.
+ */
+void halma_mcts_clear(struct halma_mcts* mcts);
+
+/**
+ * @brief Stops the worker threads and deallocates the tree.
+ */
+void halma_mcts_destroy(struct halma_mcts* mcts);
+
+#endif  // HALMA_MCTS_H_INCLUDED
@@ -0,0 +1,294 @@
+#include "halma_nnue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "halma_eval.h"
+#include "halma_playout.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86
+#endif
+
+#define EXIT_MALLOC_ERROR 39
+#define NNUE_MAGIC "HALMANN1"
+// the AVX2 code works on 32 activations at a time
+_Static_assert(HALMA_NNUE_HIDDEN % 32 == 0,
+               "HALMA_NNUE_HIDDEN has to be a multiple of 32");
+
+struct nnue_network {
+  int16_t hidden_biases[HALMA_NNUE_HIDDEN];
+  int16_t hidden_weights[HALMA_NNUE_INPUTS][HALMA_NNUE_HIDDEN];
+  int32_t hidden2_biases[HALMA_NNUE_HIDDEN2];
+  int8_t hidden2_weights[HALMA_NNUE_HIDDEN2][HALMA_NNUE_HIDDEN];
+  int32_t output_bias;
+  int8_t output_weights[HALMA_NNUE_HIDDEN2];
+};
+
+static struct nnue_network network;
+static bool network_loaded = false;
+static bool network_simd = false;
+
+/**
+ * @brief Which input a piece of set on square is for player, see halma_nnue.h.
+ * The board is turned so player's starting corner is the top left one.
+ */
+static int nnue_input(struct halma_board* board, dimension_T player,
+                      dimension_T set, int square) {
+  int y = halma_square_y(square), x = halma_square_x(square);
+  // RED starts top left, YELLOW bottom right, BLUE bottom left and GREEN top
+  // right
+  if (player == 1 || player == 2) y = HALMA_SQUARE_ROOT - 1 - y;
+  if (player == 1 || player == 3) x = HALMA_SQUARE_ROOT - 1 - x;
+  int relative = (set - player + board->players) % board->players;
+  return (relative * HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT) +
+         halma_square(y, x);
+}
+
+static void nnue_update_scalar(int16_t* accumulator, const int16_t* added,
+                               const int16_t* removed) {
+  for (int i = 0; i < HALMA_NNUE_HIDDEN; i++)
+    accumulator[i] += added[i] - removed[i];
+}
+
+/**
+ * @brief Works out the second layer's sums from an accumulator.
+ */
+static void nnue_hidden2_scalar(const int16_t* accumulator,
+                                int32_t sums[HALMA_NNUE_HIDDEN2]) {
+  uint8_t active[HALMA_NNUE_HIDDEN];
+  for (int i = 0; i < HALMA_NNUE_HIDDEN; i++)
+    active[i] = accumulator[i] < 0     ? 0
+                : accumulator[i] > 127 ? 127
+                                       : accumulator[i];
+  for (int o = 0; o < HALMA_NNUE_HIDDEN2; o++) {
+    int32_t sum = network.hidden2_biases[o];
+    for (int i = 0; i < HALMA_NNUE_HIDDEN; i++)
+      sum += active[i] * network.hidden2_weights[o][i];
+    sums[o] = sum;
+  }
+}
+
+#ifdef NNUE_X86
+__attribute__((target("avx2"))) static void nnue_update_avx2(
+    int16_t* accumulator, const int16_t* added, const int16_t* removed) {
+  for (int i = 0; i < HALMA_NNUE_HIDDEN; i += 16) {
+    __m256i sum = _mm256_loadu_si256((const __m256i*)&accumulator[i]);
+    sum = _mm256_add_epi16(sum, _mm256_loadu_si256((const __m256i*)&added[i]));
+    sum =
+        _mm256_sub_epi16(sum, _mm256_loadu_si256((const __m256i*)&removed[i]));
+    _mm256_storeu_si256((__m256i*)&accumulator[i], sum);
+  }
+}
+
+__attribute__((target("avx2"))) static void nnue_hidden2_avx2(
+    const int16_t* accumulator, int32_t sums[HALMA_NNUE_HIDDEN2]) {
+  uint8_t active[HALMA_NNUE_HIDDEN];
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i top = _mm256_set1_epi16(127);
+  const __m256i ones = _mm256_set1_epi16(1);
+  for (int i = 0; i < HALMA_NNUE_HIDDEN; i += 32) {
+    __m256i low = _mm256_loadu_si256((const __m256i*)&accumulator[i]);
+    __m256i high = _mm256_loadu_si256((const __m256i*)&accumulator[i + 16]);
+    low = _mm256_min_epi16(_mm256_max_epi16(low, zero), top);
+    high = _mm256_min_epi16(_mm256_max_epi16(high, zero), top);
+    // packing works within each 128 bit half, the permute puts the halves
+    // back in order
+    __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+    _mm256_storeu_si256((__m256i*)&active[i], packed);
+  }
+
+  for (int o = 0; o < HALMA_NNUE_HIDDEN2; o++) {
+    __m256i sum = zero;
+    for (int i = 0; i < HALMA_NNUE_HIDDEN; i += 32) {
+      // 127 * 127 * 2 still fits in 16 bits, so nothing saturates
+      __m256i products = _mm256_maddubs_epi16(
+          _mm256_loadu_si256((const __m256i*)&active[i]),
+          _mm256_loadu_si256(
+              (const __m256i*)&network.hidden2_weights[o][i]));
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                 _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    sums[o] = network.hidden2_biases[o] + _mm_cvtsi128_si32(half);
+  }
+}
+#endif
+
+static void nnue_update(int16_t* accumulator, const int16_t* added,
+                        const int16_t* removed) {
+#ifdef NNUE_X86
+  if (network_simd) {
+    nnue_update_avx2(accumulator, added, removed);
+    return;
+  }
+#endif
+  nnue_update_scalar(accumulator, added, removed);
+}
+
+bool halma_nnue_use_simd(bool enable) {
+#ifdef NNUE_X86
+  network_simd = enable && __builtin_cpu_supports("avx2");
+#else
+  network_simd = false;
+#endif
+  return network_simd;
+}
+
+bool halma_nnue_loaded() { return network_loaded; }
+
+void halma_nnue_refresh(struct halma_board* board) {
+  if (!network_loaded) return;
+  for (dimension_T player = 0; player < board->players; player++) {
+    int16_t* accumulator = board->nnue[player];
+    memcpy(accumulator, network.hidden_biases, sizeof(network.hidden_biases));
+    for (dimension_T set = 0; set < board->players; set++) {
+      bitboard_T pieces = board->pieces[set];
+      while (bitboard_any(pieces)) {
+        const int16_t* weights = network.hidden_weights[nnue_input(
+            board, player, set, bitboard_pop_first(&pieces))];
+        for (int i = 0; i < HALMA_NNUE_HIDDEN; i++)
+          accumulator[i] += weights[i];
+      }
+    }
+  }
+}
+
+void halma_nnue_move(struct halma_board* board, enum halma_piece set, int from,
+                     int to) {
+  if (!network_loaded) return;
+  dimension_T index = halma_set_index(set);
+  for (dimension_T player = 0; player < board->players; player++)
+    nnue_update(board->nnue[player],
+                network.hidden_weights[nnue_input(board, player, index, to)],
+                network.hidden_weights[nnue_input(board, player, index, from)]);
+}
+
+int halma_nnue_evaluate(struct halma_board* board, enum halma_piece set) {
+  const int16_t* accumulator = board->nnue[halma_set_index(set)];
+  int32_t sums[HALMA_NNUE_HIDDEN2];
+#ifdef NNUE_X86
+  if (network_simd)
+    nnue_hidden2_avx2(accumulator, sums);
+  else
+#endif
+    nnue_hidden2_scalar(accumulator, sums);
+
+  int32_t output = network.output_bias;
+  for (int o = 0; o < HALMA_NNUE_HIDDEN2; o++) {
+    int32_t active = sums[o] > 0 ? sums[o] >> HALMA_NNUE_SHIFT : 0;
+    output += (active > 127 ? 127 : active) * network.output_weights[o];
+  }
+  int score = output / HALMA_NNUE_OUTPUT_SCALE;
+  // nothing but an actual win can be allowed to look like one
+  if (score > HALMA_SCORE_WIN / 2) return HALMA_SCORE_WIN / 2;
+  if (score < -HALMA_SCORE_WIN / 2) return -HALMA_SCORE_WIN / 2;
+  return score;
+}
+
+/**
+ * @brief Reads count little endian numbers of size bytes each into values,
+ * sign extending them.
+ */
+static bool nnue_read(FILE* file, void* values, int size, int count) {
+  for (int i = 0; i < count; i++) {
+    unsigned char bytes[4];
+    if (fread(bytes, size, 1, file) != 1) return false;
+    uint32_t value = 0;
+    for (int b = 0; b < size; b++) value |= (uint32_t)bytes[b] << (8 * b);
+    if (size == 1) ((int8_t*)values)[i] = (int8_t)value;
+    if (size == 2) ((int16_t*)values)[i] = (int16_t)value;
+    if (size == 4) ((int32_t*)values)[i] = (int32_t)value;
+  }
+  return true;
+}
+
+static bool nnue_write(FILE* file, const void* values, int size, int count) {
+  for (int i = 0; i < count; i++) {
+    uint32_t value = size == 1   ? (uint8_t)((const int8_t*)values)[i]
+                     : size == 2 ? (uint16_t)((const int16_t*)values)[i]
+                                 : (uint32_t)((const int32_t*)values)[i];
+    unsigned char bytes[4];
+    for (int b = 0; b < size; b++) bytes[b] = value >> (8 * b);
+    if (fwrite(bytes, size, 1, file) != 1) return false;
+  }
+  return true;
+}
+
+bool halma_nnue_load(const char* filename) {
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL) return false;
+  // read somewhere else first, so a bad file doesn't leave half a network
+  struct nnue_network* loaded = malloc(sizeof(struct nnue_network));
+  if (loaded == NULL) exit(EXIT_MALLOC_ERROR);
+
+  char magic[sizeof(NNUE_MAGIC) - 1];
+  int32_t sizes[3];
+  bool ok =
+      fread(magic, sizeof(magic), 1, file) == 1 &&
+      memcmp(magic, NNUE_MAGIC, sizeof(magic)) == 0 &&
+      nnue_read(file, sizes, 4, 3) && sizes[0] == HALMA_NNUE_INPUTS &&
+      sizes[1] == HALMA_NNUE_HIDDEN && sizes[2] == HALMA_NNUE_HIDDEN2 &&
+      nnue_read(file, loaded->hidden_biases, 2, HALMA_NNUE_HIDDEN) &&
+      nnue_read(file, loaded->hidden_weights, 2,
+                HALMA_NNUE_INPUTS * HALMA_NNUE_HIDDEN) &&
+      nnue_read(file, loaded->hidden2_biases, 4, HALMA_NNUE_HIDDEN2) &&
+      nnue_read(file, loaded->hidden2_weights, 1,
+                HALMA_NNUE_HIDDEN2 * HALMA_NNUE_HIDDEN) &&
+      nnue_read(file, &loaded->output_bias, 4, 1) &&
+      nnue_read(file, loaded->output_weights, 1, HALMA_NNUE_HIDDEN2);
+  fclose(file);
+
+  if (ok) {
+    network = *loaded;
+    network_loaded = true;
+    halma_nnue_use_simd(true);
+  }
+  free(loaded);
+  return ok;
+}
+
+bool halma_nnue_save(const char* filename) {
+  FILE* file = fopen(filename, "wb");
+  if (file == NULL) return false;
+  int32_t sizes[3] = {HALMA_NNUE_INPUTS, HALMA_NNUE_HIDDEN,
+                      HALMA_NNUE_HIDDEN2};
+  bool ok =
+      fwrite(NNUE_MAGIC, sizeof(NNUE_MAGIC) - 1, 1, file) == 1 &&
+      nnue_write(file, sizes, 4, 3) &&
+      nnue_write(file, network.hidden_biases, 2, HALMA_NNUE_HIDDEN) &&
+      nnue_write(file, network.hidden_weights, 2,
+                 HALMA_NNUE_INPUTS * HALMA_NNUE_HIDDEN) &&
+      nnue_write(file, network.hidden2_biases, 4, HALMA_NNUE_HIDDEN2) &&
+      nnue_write(file, network.hidden2_weights, 1,
+                 HALMA_NNUE_HIDDEN2 * HALMA_NNUE_HIDDEN) &&
+      nnue_write(file, &network.output_bias, 4, 1) &&
+      nnue_write(file, network.output_weights, 1, HALMA_NNUE_HIDDEN2);
+  return fclose(file) == 0 && ok;
+}
+
+void halma_nnue_randomize(uint64_t seed) {
+  struct halma_rng rng;
+  halma_rng_seed(&rng, seed);
+  // small enough that a board's worth of pieces keeps most activations
+  // between 0 and 127
+  for (int i = 0; i < HALMA_NNUE_HIDDEN; i++)
+    network.hidden_biases[i] = halma_rng_next(&rng) % 64;
+  for (int i = 0; i < HALMA_NNUE_INPUTS; i++)
+    for (int o = 0; o < HALMA_NNUE_HIDDEN; o++)
+      network.hidden_weights[i][o] = (int)(halma_rng_next(&rng) % 17) - 8;
+  for (int i = 0; i < HALMA_NNUE_HIDDEN2; i++) {
+    network.hidden2_biases[i] = (int)(halma_rng_next(&rng) % 2049) - 1024;
+    for (int o = 0; o < HALMA_NNUE_HIDDEN; o++)
+      network.hidden2_weights[i][o] = (int)(halma_rng_next(&rng) % 33) - 16;
+    network.output_weights[i] = (int)(halma_rng_next(&rng) % 33) - 16;
+  }
+  network.output_bias = 0;
+  network_loaded = true;
+  halma_nnue_use_simd(true);
+}
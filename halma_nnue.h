@@ -0,0 +1,88 @@
+#ifndef HALMA_NNUE_H_INCLUDED
+#define HALMA_NNUE_H_INCLUDED
+/* halma_nnue.h
+ * Optional neural network evaluation (NNUE), only in builds with HALMA_NNUE
+ * defined ('make NNUE=1'). Once a network is loaded halma_evaluate uses it
+ * instead of the built in evaluation.
+ *
+ * The network's inputs are which set is on which tile, as seen by one player:
+ * sets are numbered starting from that player, and the board is turned so the
+ * player starts in the top left corner. A move turns one input off and one on,
+ * so rather than working out the first layer at every node each board keeps
+ * it worked out for every player (the accumulator, see HALMA_NNUE_HIDDEN) and
+ * updates it as pieces move. Only the two small layers after it are run per
+ * evaluation, in integers, with AVX2 if the CPU has it.
+ *
+ * Weights file, every number little endian:
+ *   "HALMANN1"
+ *   uint32 inputs, hidden, hidden2: HALMA_NNUE_INPUTS, HALMA_NNUE_HIDDEN and
+ *     HALMA_NNUE_HIDDEN2 of the build, checked when loading
+ *   int16 first layer biases[hidden], weights[inputs][hidden]
+ *   int32 second layer biases[hidden2], int8 weights[hidden2][hidden]
+ *   int32 output bias, int8 output weights[hidden2]
+ * Activations are the layer's sums clamped to 0-127, after the second layer
+ * they are shifted down by HALMA_NNUE_SHIFT first. The output is in
+ * 1/HALMA_NNUE_OUTPUT_SCALE tiles of distance.
+ */
+#include <stdint.h>
+
+#include "halma.h"
+
+#define HALMA_NNUE_INPUTS \
+  (HALMA_MAX_PLAYERS * HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT)
+#define HALMA_NNUE_HIDDEN2 32
+#define HALMA_NNUE_SHIFT 6
+#define HALMA_NNUE_OUTPUT_SCALE 16
+
+/**
+ * @brief Loads a network from a weights file. Boards set up before this don't
+ * have the network's accumulators, call halma_nnue_refresh on them.
+ *
+ * @param filename the weights file.
+ * @return true if it loaded, otherwise the network in use (if any) is kept.
+ */
+bool halma_nnue_load(const char* filename);
+
+/**
+ * @brief Writes the network in use to a weights file.
+ * @return true if it was written.
+ */
+bool halma_nnue_save(const char* filename);
+
+/**
+ * @brief Uses a network with random weights, for benchmarks or as somewhere
+ * to start training from. Boards need halma_nnue_refresh like after loading.
+ */
+void halma_nnue_randomize(uint64_t seed);
+
+/**
+ * @brief Checks if there is a network in use.
+ */
+bool halma_nnue_loaded();
+
+/**
+ * @brief Turns AVX2 on or off, it's on by default if the CPU has it.
+ * @return bool whether AVX2 is in use now.
+ */
+bool halma_nnue_use_simd(bool enable);
+
+/**
+ * @brief Works out every player's accumulator from scratch. halma.c does this
+ * whenever a board is set up, after that halma_nnue_move keeps them updated.
+ */
+void halma_nnue_refresh(struct halma_board* board);
+
+/**
+ * @brief Updates every player's accumulator for the piece of set on from
+ * moving to to, called by halma.c whenever a piece moves.
+ */
+void halma_nnue_move(struct halma_board* board, enum halma_piece set, int from,
+                     int to);
+
+/**
+ * @brief Scores the board for one set with the network, a network has to be
+ * loaded. Same units as halma_evaluate.
+ */
+int halma_nnue_evaluate(struct halma_board* board, enum halma_piece set);
+
+#endif  // HALMA_NNUE_H_INCLUDED
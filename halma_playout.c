@@ -0,0 +1,73 @@
+#include "halma_playout.h"
+
+#include <limits.h>
+#include <stddef.h>
+
+#include "halma_eval.h"
+
+// how many pieces with moves are looked at each ply
+#define PLAYOUT_SAMPLES 3
+// one move in this many is completely random
+#define PLAYOUT_RANDOM 8
+
+void halma_rng_seed(struct halma_rng* rng, uint64_t seed) {
+  // splitmix64 the seed so similar seeds don't give similar sequences, and so
+  // the state is never 0, which xorshift can't get out of
+  uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  rng->state = (z ^ (z >> 31)) | 1;
+}
+
+/**
+ * @brief Picks one of the tiles in targets at random, targets can't be empty.
+ */
+static int playout_random_target(bitboard_T targets, struct halma_rng* rng) {
+  int skip = halma_rng_next(rng) % bitboard_popcount(targets);
+  while (skip-- > 0) bitboard_pop_first(&targets);
+  return bitboard_pop_first(&targets);
+}
+
+/**
+ * @brief Picks a move for whoever's turn it is.
+ * @return halma_move_T the move, from == to if there was nothing to move.
+ */
+static halma_move_T playout_pick_move(struct halma_board* board,
+                                      struct halma_rng* rng) {
+  enum halma_piece turn = halma_whos_turn(board);
+  const unsigned char* pieces = board->piece_list[halma_set_index(turn)];
+  int start = halma_rng_next(rng) % board->player_pieces;
+  bool random = halma_rng_next(rng) % PLAYOUT_RANDOM == 0;
+  halma_move_T best = halma_move(0, 0);
+  int best_gain = INT_MIN, sampled = 0;
+
+  for (int i = 0; i < board->player_pieces && sampled < PLAYOUT_SAMPLES; i++) {
+    int from = pieces[(start + i) % board->player_pieces];
+    bitboard_T targets = halma_piece_targets(board, turn, from, NULL);
+    if (!bitboard_any(targets)) continue;
+    if (random) return halma_move(from, playout_random_target(targets, rng));
+    sampled++;
+
+    int distance = halma_square_distance(board, turn, from);
+    while (bitboard_any(targets)) {
+      int to = bitboard_pop_first(&targets);
+      int gain = distance - halma_square_distance(board, turn, to);
+      if (gain > best_gain) {
+        best_gain = gain;
+        best = halma_move(from, to);
+      }
+    }
+  }
+  return best;
+}
+
+enum halma_piece halma_playout(struct halma_board* board, struct halma_rng* rng,
+                               int max_plies) {
+  for (int ply = 0; ply < max_plies && board->turns < SHRT_MAX; ply++) {
+    halma_move_T move = playout_pick_move(board, rng);
+    enum halma_piece winner =
+        halma_play_move(board, halma_move_from(move), halma_move_to(move));
+    if (winner != EMPTY) return winner;
+  }
+  return EMPTY;
+}
@@ -0,0 +1,55 @@
+#ifndef HALMA_PLAYOUT_H_INCLUDED
+#define HALMA_PLAYOUT_H_INCLUDED
+/* halma_playout.h
+ * Plays games out from a position to the end with quick, lightly guided
+ * moves, for Monte Carlo searches. Nothing is allocated and no move tables or
+ * move lists are built, each ply only looks at a few pieces.
+ */
+#include <stdint.h>
+
+#include "halma.h"
+
+// playouts that go on longer than this many plies are stopped, games where
+// nobody can make progress would otherwise never end
+#define HALMA_PLAYOUT_MAX_PLIES 2000
+
+/**
+ * @brief State of a xorshift64* random number generator. Every thread needs
+ * its own.
+ */
+struct halma_rng {
+  uint64_t state;
+};
+
+/**
+ * @brief Seeds a random number generator. Any seed is fine, including 0.
+ */
+void halma_rng_seed(struct halma_rng* rng, uint64_t seed);
+
+/**
+ * @brief Next random number from a generator.
+ */
+static inline uint32_t halma_rng_next(struct halma_rng* rng) {
+  rng->state ^= rng->state >> 12;
+  rng->state ^= rng->state << 25;
+  rng->state ^= rng->state >> 27;
+  return (rng->state * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+/**
+ * @brief Plays the game on board out until somebody wins or max_plies plies
+ * have gone by. Most moves take a piece as far towards its goal as one of a
+ * few randomly picked pieces can go, the rest are completely random.
+ *
+ * @param board the board to play on, left at the last position reached. Must
+ * not already be won.
+ * @param rng random number generator to use.
+ * @param max_plies most plies to play, HALMA_PLAYOUT_MAX_PLIES is a good
+ * default.
+ * @return enum halma_piece the player/set that won, EMPTY if the playout was
+ * stopped first.
+ */
+enum halma_piece halma_playout(struct halma_board* board, struct halma_rng* rng,
+                               int max_plies);
+
+#endif  // HALMA_PLAYOUT_H_INCLUDED
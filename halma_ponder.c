@@ -0,0 +1,143 @@
+#include "halma_ponder.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#define EXIT_MALLOC_ERROR 39
+#define EXIT_THREAD_ERROR 40
+// longest the hint moves get searched, after that it's the computer's turn
+// to think about its reply
+#define PONDER_HINT_SECONDS 3.0
+
+struct halma_ponder {
+  int threads;
+  enum halma_search_mode mode;
+  // the position being pondered, only changed while no thread is running
+  struct halma_board board;
+  bool reply;
+  bool pending;  // a position is set but pondering hasn't started yet
+  bool running;  // the thread has been started and not joined yet
+  pthread_t thread;
+  atomic_bool stop;
+  // lock and hinted guard hint, the thread signals hinted once it has
+  // ranked the moves the first time
+  pthread_mutex_t lock;
+  pthread_cond_t hinted_signal;
+  bool hinted;
+  struct halma_ranking hint;
+};
+
+/**
+ * @brief Plays move in the pondered position and searches the reply until
+ * stopped, all that is kept of it is what the engine's table learned.
+ */
+static void ponder_reply(struct halma_ponder* ponder, halma_move_T move) {
+  struct halma_board board = ponder->board;
+  struct halma_undo record;
+  struct halma_undo_stack undo;
+  halma_init_undo(&undo, &record, 1);
+  if (halma_make_move(&board, &undo, halma_move_from(move),
+                      halma_move_to(move)) != 0 ||
+      halma_check_victory_all(&board) != EMPTY)
+    return;
+
+  // the same pondering session as the ranking, so the table isn't aged again
+  struct halma_limits limits = {0, 0, ponder->mode, ponder->threads, 0,
+                                &ponder->stop, true};
+  halma_engine_best_move(&board, &limits);
+}
+
+/**
+ * @brief Hands a ranking to anyone waiting on a hint.
+ */
+static void ponder_hinted(const struct halma_ranking* ranking, void* arg) {
+  struct halma_ponder* ponder = arg;
+  pthread_mutex_lock(&ponder->lock);
+  ponder->hint = *ranking;
+  ponder->hinted = true;
+  pthread_cond_broadcast(&ponder->hinted_signal);
+  pthread_mutex_unlock(&ponder->lock);
+}
+
+static void* ponder_main(void* arg) {
+  struct halma_ponder* ponder = arg;
+  struct halma_limits limits = {0, 0, ponder->mode, 1,
+                                halma_engine_clock() + PONDER_HINT_SECONDS,
+                                &ponder->stop};
+  // one search deepening on its own, a better hint is ready as soon as a
+  // depth is done. It's handed on once more at the end in case there were
+  // no moves to rank.
+  struct halma_ranking ranking = halma_engine_rank_moves(
+      &ponder->board, &limits, ponder_hinted, ponder);
+  ponder_hinted(&ranking, ponder);
+
+  if (ponder->reply && ponder->hint.count > 0 &&
+      !atomic_load_explicit(&ponder->stop, memory_order_relaxed))
+    ponder_reply(ponder, ponder->hint.moves[0]);
+  return NULL;
+}
+
+struct halma_ponder* halma_ponder_create(int threads,
+                                         enum halma_search_mode mode) {
+  struct halma_ponder* ponder = malloc(sizeof(struct halma_ponder));
+  if (ponder == NULL) exit(EXIT_MALLOC_ERROR);
+  ponder->threads = threads;
+  ponder->mode = mode;
+  ponder->reply = false;
+  ponder->pending = false;
+  ponder->running = false;
+  atomic_init(&ponder->stop, false);
+  pthread_mutex_init(&ponder->lock, NULL);
+  pthread_cond_init(&ponder->hinted_signal, NULL);
+  ponder->hinted = false;
+  ponder->hint.count = 0;
+  ponder->hint.depth = 0;
+  return ponder;
+}
+
+void halma_ponder_set_position(struct halma_ponder* ponder,
+                               struct halma_board* board, bool reply) {
+  halma_ponder_stop(ponder);
+  ponder->board = *board;
+  ponder->reply = reply;
+  ponder->pending = true;
+  ponder->hinted = false;
+  ponder->hint.count = 0;
+  ponder->hint.depth = 0;
+}
+
+void halma_ponder_idle(struct halma_ponder* ponder) {
+  if (!ponder->pending || ponder->running) return;
+  ponder->pending = false;
+  atomic_store(&ponder->stop, false);
+  if (pthread_create(&ponder->thread, NULL, ponder_main, ponder))
+    exit(EXIT_THREAD_ERROR);
+  ponder->running = true;
+}
+
+void halma_ponder_hint(struct halma_ponder* ponder,
+                       struct halma_ranking* hint) {
+  halma_ponder_idle(ponder);
+  pthread_mutex_lock(&ponder->lock);
+  // depth 1 can't be stopped part way, so once the thread is running this
+  // never waits for long
+  while (ponder->running && !ponder->hinted)
+    pthread_cond_wait(&ponder->hinted_signal, &ponder->lock);
+  *hint = ponder->hint;
+  pthread_mutex_unlock(&ponder->lock);
+}
+
+void halma_ponder_stop(struct halma_ponder* ponder) {
+  ponder->pending = false;
+  if (!ponder->running) return;
+  atomic_store(&ponder->stop, true);
+  pthread_join(ponder->thread, NULL);
+  ponder->running = false;
+}
+
+void halma_ponder_destroy(struct halma_ponder* ponder) {
+  halma_ponder_stop(ponder);
+  pthread_mutex_destroy(&ponder->lock);
+  pthread_cond_destroy(&ponder->hinted_signal);
+  free(ponder);
+}
@@ -0,0 +1,67 @@
+#ifndef HALMA_PONDER_H_INCLUDED
+#define HALMA_PONDER_H_INCLUDED
+/* halma_ponder.h
+ * Thinking ahead while a person decides on their move. A background thread
+ * ranks the best moves for them, for hints, then searches the position after
+ * the best of them so that most of the computer's reply is already in the
+ * engine's transposition table by the time it's asked for.
+ * Only one thing can use the engine at a time, stop pondering before
+ * searching with it.
+ */
+#include "halma.h"
+#include "halma_engine.h"
+
+struct halma_ponder;
+
+/**
+ * @brief Sets up pondering, nothing is started until there is a position.
+ *
+ * @param threads threads to search the computer's reply with.
+ * @param mode how the computer searches 4 player games.
+ * @return struct halma_ponder* on the heap.
+ */
+struct halma_ponder* halma_ponder_create(int threads,
+                                         enum halma_search_mode mode);
+
+/**
+ * @brief Stops pondering whatever it was and makes board the position to
+ * ponder next. Pondering doesn't start until halma_ponder_idle is called, so
+ * it only happens while a person is actually thinking.
+ *
+ * @param ponder the ponderer.
+ * @param board the position, copied.
+ * @param reply whether to ponder the computer's reply after the hint move.
+ */
+void halma_ponder_set_position(struct halma_ponder* ponder,
+                               struct halma_board* board, bool reply);
+
+/**
+ * @brief Starts pondering the position set with halma_ponder_set_position, if
+ * it hasn't been already. Meant to be called whenever the program is waiting
+ * on a person.
+ */
+void halma_ponder_idle(struct halma_ponder* ponder);
+
+/**
+ * @brief Gets the best moves found so far for the position being pondered,
+ * starting pondering if it hasn't been. Only waits if not even the moves
+ * themselves have been scored yet, which takes next to no time.
+ *
+ * @param ponder the ponderer.
+ * @param hint filled in with the moves, count is 0 if there are none or no
+ * position is set.
+ */
+void halma_ponder_hint(struct halma_ponder* ponder, struct halma_ranking* hint);
+
+/**
+ * @brief Stops pondering and waits for the thread to finish, after this the
+ * engine is free to use.
+ */
+void halma_ponder_stop(struct halma_ponder* ponder);
+
+/**
+ * @brief Stops pondering and deallocates the ponderer.
+ */
+void halma_ponder_destroy(struct halma_ponder* ponder);
+
+#endif  // HALMA_PONDER_H_INCLUDED
@@ -0,0 +1,274 @@
+/* halma_tablegen.c
+ * Build time generator for halma_tables.c, run by the makefile. Works out
+ * everything about the board that never changes (neighbors, jumps, where each
+ * set starts and where it needs to get to) and prints it as C source so it can
+ * be compiled straight into the game. See halma_tables.h for what each table
+ * holds.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "halma.h"
+#include "halma_tables.h"
+
+#define CELLS (HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT)
+
+static const int directions[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                     {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+
+/* splitmix64, a small generator that is plenty random for hash keys. The
+ * seed is fixed so every build gets the same keys.
+ */
+static uint64_t zobrist_state = 0x48616C6D61ULL;
+static uint64_t splitmix64(void) {
+  uint64_t z = (zobrist_state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static bool on_board(int y, int x) {
+  return y >= 0 && y < HALMA_SQUARE_ROOT && x >= 0 && x < HALMA_SQUARE_ROOT;
+}
+
+static int manhattan(int a, int b) {
+  return abs(halma_square_y(a) - halma_square_y(b)) +
+         abs(halma_square_x(a) - halma_square_x(b));
+}
+
+/**
+ * @brief Fills in how far every tile is from finishing in goal, see
+ * halma_goal_distances. An empty goal leaves every distance at 0.
+ */
+static void gen_goal_distances(bitboard_T goal,
+                               unsigned char distances[CELLS]) {
+  const int corners[4] = {
+      halma_square(0, 0), halma_square(0, HALMA_SQUARE_ROOT - 1),
+      halma_square(HALMA_SQUARE_ROOT - 1, 0),
+      halma_square(HALMA_SQUARE_ROOT - 1, HALMA_SQUARE_ROOT - 1)};
+  int corner = -1, depth = 0;
+  for (int i = 0; i < 4; i++)
+    if (bitboard_getbit(&goal, corners[i])) corner = corners[i];
+  for (int i = 0; i < CELLS; i++) distances[i] = 0;
+  if (corner < 0) return;
+
+  for (int i = 0; i < CELLS; i++)
+    if (bitboard_getbit(&goal, i) && manhattan(i, corner) > depth)
+      depth = manhattan(i, corner);
+  for (int i = 0; i < CELLS; i++) {
+    if (bitboard_getbit(&goal, i)) {
+      distances[i] = manhattan(i, corner);
+      continue;
+    }
+    int nearest = 2 * HALMA_SQUARE_ROOT;
+    for (int o = 0; o < CELLS; o++)
+      if (bitboard_getbit(&goal, o) && manhattan(i, o) < nearest)
+        nearest = manhattan(i, o);
+    distances[i] = nearest + depth;
+  }
+}
+
+static void print_bitboard(bitboard_T set) {
+  printf("{{");
+  for (int i = 0; i < BITBOARD_WORDS; i++)
+    printf("0x%016llXULL%s", (unsigned long long)set.words[i],
+           i + 1 < BITBOARD_WORDS ? ", " : "");
+  printf("}}");
+}
+
+/* Camp shapes for each board size, the length of each row of the camp
+ * starting from the edge. RED's camp is in the top left corner and the others
+ * are mirrored into the other corners from it. 16 is the original board.
+ */
+#if HALMA_SQUARE_ROOT == 16
+static const int camp_rows_2p[] = {5, 5, 4, 3, 2};
+static const int camp_rows_4p[] = {4, 4, 3, 2};
+#elif HALMA_SQUARE_ROOT == 10
+static const int camp_rows_2p[] = {5, 4, 3, 2, 1};
+static const int camp_rows_4p[] = {4, 3, 2, 1};
+#elif HALMA_SQUARE_ROOT == 8
+static const int camp_rows_2p[] = {4, 3, 2, 1};
+static const int camp_rows_4p[] = {3, 2, 1};
+#endif
+
+static void gen_camp(
+    enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT],
+    const int rows[], int count, enum halma_piece set) {
+  bool flip_y = set == BLUE || set == YELLOW;
+  bool flip_x = set == GREEN || set == YELLOW;
+  for (int i = 0; i < count; i++)
+    for (int o = 0; o < rows[i]; o++)
+      grid[flip_y ? HALMA_SQUARE_ROOT - 1 - i : i]
+          [flip_x ? HALMA_SQUARE_ROOT - 1 - o : o] = set;
+}
+
+static void gen_camps_4p(
+    enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT]) {
+  int count = sizeof(camp_rows_4p) / sizeof(camp_rows_4p[0]);
+  for (enum halma_piece set = RED; set <= GREEN; set++)
+    gen_camp(grid, camp_rows_4p, count, set);
+}
+
+static void gen_camps_2p(
+    enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT]) {
+  int count = sizeof(camp_rows_2p) / sizeof(camp_rows_2p[0]);
+  gen_camp(grid, camp_rows_2p, count, RED);
+  gen_camp(grid, camp_rows_2p, count, YELLOW);
+}
+
+int main() {
+  bitboard_T camps[HALMA_VARIANTS][HALMA_MAX_PLAYERS];
+  int pieces[HALMA_VARIANTS];
+
+  for (int variant = 0; variant < HALMA_VARIANTS; variant++) {
+    enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT] = {{EMPTY}};
+    if (variant == HALMA_VARIANT_2P)
+      gen_camps_2p(grid);
+    else
+      gen_camps_4p(grid);
+    for (int set = 0; set < HALMA_MAX_PLAYERS; set++)
+      camps[variant][set] = bitboard_empty();
+    for (int i = 0; i < CELLS; i++)
+      if (grid[halma_square_y(i)][halma_square_x(i)] != EMPTY)
+        bitboard_setbit(
+            &camps[variant]
+                  [halma_set_index(grid[halma_square_y(i)][halma_square_x(i)])],
+            i);
+    pieces[variant] = bitboard_popcount(camps[variant][0]);
+    if (pieces[variant] > HALMA_MAX_PIECES) {
+      fprintf(stderr, "variant %d has more than HALMA_MAX_PIECES pieces\n",
+              variant);
+      return EXIT_FAILURE;
+    }
+  }
+
+  printf("/* Generated by halma_tablegen, do not edit. */\n");
+  printf("#include \"halma_tables.h\"\n\n");
+
+  printf("const bitboard_T halma_neighbor_sets[%d] = {\n", CELLS);
+  for (int i = 0; i < CELLS; i++) {
+    bitboard_T set = bitboard_empty();
+    for (int d = 0; d < 8; d++) {
+      int y = halma_square_y(i) + directions[d][0];
+      int x = halma_square_x(i) + directions[d][1];
+      if (on_board(y, x)) bitboard_setbit(&set, halma_square(y, x));
+    }
+    printf("    ");
+    print_bitboard(set);
+    printf(",\n");
+  }
+  printf("};\n\n");
+
+  printf("const bitboard_T halma_landing_sets[%d] = {\n", CELLS);
+  for (int i = 0; i < CELLS; i++) {
+    bitboard_T set = bitboard_empty();
+    for (int d = 0; d < 8; d++) {
+      int y = halma_square_y(i) + (2 * directions[d][0]);
+      int x = halma_square_x(i) + (2 * directions[d][1]);
+      if (on_board(y, x)) bitboard_setbit(&set, halma_square(y, x));
+    }
+    printf("    ");
+    print_bitboard(set);
+    printf(",\n");
+  }
+  printf("};\n\n");
+
+  printf("const struct halma_jump halma_jumps[%d][8] = {\n", CELLS);
+  for (int i = 0; i < CELLS; i++) {
+    printf("    {");
+    for (int d = 0; d < 8; d++) {
+      int y = halma_square_y(i) + (2 * directions[d][0]);
+      int x = halma_square_x(i) + (2 * directions[d][1]);
+      if (!on_board(y, x)) continue;
+      printf("{%d, %d}, ",
+             halma_square(halma_square_y(i) + directions[d][0],
+                          halma_square_x(i) + directions[d][1]),
+             halma_square(y, x));
+    }
+    printf("},\n");
+  }
+  printf("};\n\n");
+
+  printf("const unsigned char halma_jump_counts[%d] = {\n", CELLS);
+  for (int i = 0; i < CELLS; i++) {
+    int count = 0;
+    for (int d = 0; d < 8; d++)
+      count += on_board(halma_square_y(i) + (2 * directions[d][0]),
+                        halma_square_x(i) + (2 * directions[d][1]));
+    printf("%s%d,%s", halma_square_x(i) ? "" : "    ", count,
+           halma_square_x(i) == HALMA_SQUARE_ROOT - 1 ? "\n" : " ");
+  }
+  printf("};\n\n");
+
+  printf("const bitboard_T halma_camp_sets[%d][%d] = {\n", HALMA_VARIANTS,
+         HALMA_MAX_PLAYERS);
+  for (int variant = 0; variant < HALMA_VARIANTS; variant++) {
+    printf("    {\n");
+    for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+      printf("        ");
+      print_bitboard(camps[variant][set]);
+      printf(",\n");
+    }
+    printf("    },\n");
+  }
+  printf("};\n\n");
+
+  // each set's goal is wherever the set on the opposite corner starts
+  static const enum halma_piece opposite[HALMA_MAX_PLAYERS] = {YELLOW, RED,
+                                                               GREEN, BLUE};
+  printf("const bitboard_T halma_goal_sets[%d][%d] = {\n", HALMA_VARIANTS,
+         HALMA_MAX_PLAYERS);
+  for (int variant = 0; variant < HALMA_VARIANTS; variant++) {
+    printf("    {\n");
+    for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+      printf("        ");
+      print_bitboard(camps[variant][halma_set_index(opposite[set])]);
+      printf(",\n");
+    }
+    printf("    },\n");
+  }
+  printf("};\n\n");
+
+  printf("const unsigned char halma_goal_distances[%d][%d][%d] = {\n",
+         HALMA_VARIANTS, HALMA_MAX_PLAYERS, CELLS);
+  for (int variant = 0; variant < HALMA_VARIANTS; variant++) {
+    printf("    {\n");
+    for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+      unsigned char distances[CELLS];
+      gen_goal_distances(camps[variant][halma_set_index(opposite[set])],
+                         distances);
+      printf("        {\n");
+      for (int i = 0; i < CELLS; i++)
+        printf("%s%2d,%s", halma_square_x(i) ? "" : "            ",
+               distances[i],
+               halma_square_x(i) == HALMA_SQUARE_ROOT - 1 ? "\n" : " ");
+      printf("        },\n");
+    }
+    printf("    },\n");
+  }
+  printf("};\n\n");
+
+  printf("const dimension_T halma_variant_pieces[%d] = {", HALMA_VARIANTS);
+  for (int variant = 0; variant < HALMA_VARIANTS; variant++)
+    printf("%d%s", pieces[variant], variant + 1 < HALMA_VARIANTS ? ", " : "");
+  printf("};\n\n");
+
+  printf("const uint64_t halma_zobrist_pieces[%d][%d] = {\n",
+         HALMA_MAX_PLAYERS, CELLS);
+  for (int set = 0; set < HALMA_MAX_PLAYERS; set++) {
+    printf("    {\n");
+    for (int i = 0; i < CELLS; i++)
+      printf("%s0x%016llXULL,%s", i % 3 ? "" : "        ",
+             (unsigned long long)splitmix64(),
+             i % 3 == 2 || i + 1 == CELLS ? "\n" : " ");
+    printf("    },\n");
+  }
+  printf("};\n\n");
+
+  printf("const uint64_t halma_zobrist_turn[%d] = {\n", HALMA_MAX_PLAYERS);
+  for (int set = 0; set < HALMA_MAX_PLAYERS; set++)
+    printf("    0x%016llXULL,\n", (unsigned long long)splitmix64());
+  printf("};\n");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#ifndef HALMA_TABLES_H_INCLUDED
+#define HALMA_TABLES_H_INCLUDED
+/* halma_tables.h
+ * Lookup tables for everything about the board that never changes. The
+ * tables themselves are in halma_tables.c, which halma_tablegen writes at
+ * build time, and are shared by every board.
+ */
+#include "halma.h"
+
+/**
+ * @brief The different board setups, each has its own camps and goals.
+ */
+enum halma_variant { HALMA_VARIANT_2P = 0, HALMA_VARIANT_4P, HALMA_VARIANTS };
+
+#define halma_variant(board) \
+  ((board)->players == 2 ? HALMA_VARIANT_2P : HALMA_VARIANT_4P)
+
+/**
+ * @brief A single jump, the tile jumped over and the tile landed on.
+ */
+struct halma_jump {
+  unsigned char over;
+  unsigned char landing;
+};
+
+// for each tile, its (up to 8) neighbors
+extern const bitboard_T
+    halma_neighbor_sets[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+
+// for each tile, every tile a jump from it could land on
+extern const bitboard_T
+    halma_landing_sets[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+
+// for each tile, every jump that stays on the board. Only the first
+// halma_jump_counts entries of each are used.
+extern const struct halma_jump
+    halma_jumps[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT][8];
+extern const unsigned char
+    halma_jump_counts[HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+
+// where each set starts, and where it needs to get to, indexed
+// [variant][halma_set_index(set)]. Sets not in a variant are empty.
+extern const bitboard_T halma_camp_sets[HALMA_VARIANTS][HALMA_MAX_PLAYERS];
+extern const bitboard_T halma_goal_sets[HALMA_VARIANTS][HALMA_MAX_PLAYERS];
+
+// how far a piece of each set is from being done on every tile, in steps
+// along the rows and columns, indexed [variant][halma_set_index(set)][square].
+// On a goal tile it's how far the tile is from the goal's corner, anywhere
+// else it's the way to the nearest goal tile plus the depth of the goal (its
+// furthest tile from the corner). Sets not in a variant are 0 everywhere.
+extern const unsigned char
+    halma_goal_distances[HALMA_VARIANTS][HALMA_MAX_PLAYERS]
+                        [HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+
+// how many pieces each set has in a variant
+extern const dimension_T halma_variant_pieces[HALMA_VARIANTS];
+
+// Zobrist hash keys, one per set per tile, and one for each set whose turn it
+// is. A board's hash is every key for what's on it XORed together.
+extern const uint64_t
+    halma_zobrist_pieces[HALMA_MAX_PLAYERS]
+                        [HALMA_SQUARE_ROOT * HALMA_SQUARE_ROOT];
+extern const uint64_t halma_zobrist_turn[HALMA_MAX_PLAYERS];
+
+#define halma_goal(board, set) \
+  (halma_goal_sets[halma_variant(board)][halma_set_index(set)])
+
+#endif  // HALMA_TABLES_H_INCLUDED
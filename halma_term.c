@@ -1,6 +1,8 @@
 #include "halma_term.h"
 
 #include <ctype.h>
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,16 +27,51 @@ char input_buffer[INPUT_BUFFER_SIZE];
 const char* piece_name[] = {"EMPTY", "RED", "YELLOW", "BLUE", "GREEN"};
 
 #define EXIT_STDIN_ERROR 30
+// how often the idle function gets called while waiting for input
+#define INPUT_IDLE_MS 100
+
+static void (*idle_function)(void*) = NULL;
+static void* idle_argument = NULL;
+
+void halma_term_on_idle(void (*idle)(void*), void* arg) {
+  idle_function = idle;
+  idle_argument = arg;
+}
+
+/**
+ * @brief Reads a line of input into input_buffer, calling the idle function
+ * every so often until something is typed.
+ */
+static void halma_term_read_line() {
+  static bool unbuffered = false;
+  if (!unbuffered) {
+    // anything stdio buffered wouldn't show up to poll, it would wait on
+    // input that has already been read
+    setvbuf(stdin, NULL, _IONBF, 0);
+    unbuffered = true;
+  }
+  // the prompt has to be out before waiting, fgets would do this itself
+  fflush(stdout);
+
+  struct pollfd input = {.fd = fileno(stdin), .events = POLLIN};
+  int ready;
+  while ((ready = poll(&input, 1, INPUT_IDLE_MS)) <= 0) {
+    if (ready < 0 && errno != EINTR) break;
+    if (ready == 0 && idle_function != NULL) idle_function(idle_argument);
+  }
+
+  if (!fgets(input_buffer, INPUT_BUFFER_SIZE, stdin)) {
+    // something has gone very wrong, likely an issue with stdin
+    perror(NULL);
+    exit(EXIT_STDIN_ERROR);
+  }
+}
 
 char halma_term_greeting() {
   char selection = '\0';
   do {
     printf("Main Menu\n[N]ew Game\n[L]oad Game\n[Q]uit\nSelection: ");
-    if (!fgets(input_buffer, INPUT_BUFFER_SIZE, stdin)) {
-      // something has gone very wrong, likely an issue with stdin
-      perror(NULL);
-      exit(EXIT_STDIN_ERROR);
-    }
+    halma_term_read_line();
 
     if (1 != sscanf(input_buffer, " %c", &selection)) {
       // we already checked the input stdin, no need to do so again here
@@ -56,13 +93,9 @@ char halma_term_game_menu(enum halma_piece turn) {
     printf("\nGame Menu\nCurrent Turn: %s\n", piece_name[turn]);
     printf(
         "Print [B]oard\nPrint Movable [P]ieces\nPrint Piece [T]argets\n[M]ake "
-        "Move\n");
+        "Move\n[H]int\n");
     printf("[S]ave Game\n[Q]uit to Main Menu\nSelection: ");
-    if (!fgets(input_buffer, INPUT_BUFFER_SIZE, stdin)) {
-      // something has gone very wrong, likely an issue with stdin
-      perror(NULL);
-      exit(EXIT_STDIN_ERROR);
-    }
+    halma_term_read_line();
 
     if (1 != sscanf(input_buffer, " %c", &selection)) {
       // we already checked the input stdin, no need to do so again here
@@ -72,7 +105,8 @@ char halma_term_game_menu(enum halma_piece turn) {
 
     selection = toupper(selection);
     if (selection == 'B' || selection == 'P' || selection == 'T' ||
-        selection == 'M' || selection == 'S' || selection == 'Q')
+        selection == 'M' || selection == 'H' || selection == 'S' ||
+        selection == 'Q')
       return selection;
 
     printf("Invalid selection.\n");
@@ -81,11 +115,7 @@ char halma_term_game_menu(enum halma_piece turn) {
 
 char* halma_get_filename() {
   printf("Enter filename: ");
-  if (!fgets(input_buffer, INPUT_BUFFER_SIZE, stdin)) {
-    // something has gone very wrong, likely an issue with stdin
-    perror(NULL);
-    exit(EXIT_STDIN_ERROR);
-  }
+  halma_term_read_line();
   input_buffer[strcspn(input_buffer, "\n")] = '\0';
   return input_buffer;
 }
@@ -94,15 +124,17 @@ void halma_term_filename_perror() {
   perror("There was an error loading the file");
 }
 
+void halma_term_no_network(const char* filename) {
+  printf("No usable network in %s, the computer uses its built in "
+         "evaluation.\n",
+         filename);
+}
+
 dimension_T halma_get_game_type() {
   int players;
   do {
     printf("Enter game type, [2] player, [4] player: ");
-    if (!fgets(input_buffer, INPUT_BUFFER_SIZE, stdin)) {
-      // something has gone very wrong, likely an issue with stdin
-      perror(NULL);
-      exit(EXIT_STDIN_ERROR);
-    }
+    halma_term_read_line();
 
     if (1 != sscanf(input_buffer, " %i", &players)) {
       // we already checked the input stdin, no need to do so again here
@@ -119,6 +151,60 @@ dimension_T halma_get_game_type() {
   } while (true);
 }
 
+bool halma_get_computer_opponent() {
+  char selection = '\0';
+  do {
+    printf("Play against the computer? [Y]es, [N]o: ");
+    halma_term_read_line();
+
+    if (1 != sscanf(input_buffer, " %c", &selection)) {
+      // we already checked the input stdin, no need to do so again here
+      printf("Invalid input format.\n");
+      continue;
+    }
+
+    selection = toupper(selection);
+    if (selection == 'Y' || selection == 'N') return selection == 'Y';
+
+    printf("Invalid selection.\n");
+  } while (true);
+}
+
+void halma_print_computer_move(enum halma_piece turn, halma_move_T move) {
+  // same [XY] order the coordinates are typed in
+  printf("%s moves %1X%1X to %1X%1X.\n", piece_name[turn],
+         halma_square_x(halma_move_from(move)),
+         halma_square_y(halma_move_from(move)),
+         halma_square_x(halma_move_to(move)),
+         halma_square_y(halma_move_to(move)));
+}
+
+void halma_term_illegal_computer_move(enum halma_piece turn) {
+  fprintf(stderr, "The computer's move for %s is not legal, stopping.\n",
+          piece_name[turn]);
+}
+
+void halma_term_move_rejected(enum halma_piece turn) {
+  printf("That move couldn't be made, it is still %s's turn.\n",
+         piece_name[turn]);
+}
+
+void halma_print_hint(enum halma_piece turn,
+                      const struct halma_ranking* hint) {
+  if (hint->count == 0) {
+    printf("No hint for %s.\n", piece_name[turn]);
+    return;
+  }
+  printf("Best moves for %s, looking %d move%s ahead:\n", piece_name[turn],
+         hint->depth, hint->depth == 1 ? "" : "s");
+  for (int i = 0; i < hint->count; i++)
+    printf("%d. %1X%1X to %1X%1X, score %d\n", i + 1,
+           halma_square_x(halma_move_from(hint->moves[i])),
+           halma_square_y(halma_move_from(hint->moves[i])),
+           halma_square_x(halma_move_to(hint->moves[i])),
+           halma_square_y(halma_move_to(hint->moves[i])), hint->scores[i]);
+}
+
 void halma_no_moves_error(enum halma_piece turn){
   printf("%s has no possible moves, turn forfeit.\n", piece_name[turn]);
 }
@@ -177,11 +263,7 @@ dimension_T halma_select_piece(struct halma_board* board,
 
   do {
     printf("Enter coordinates of %s piece to move [XY]: ", piece_name[turn]);
-    if (!fgets(input_buffer, INPUT_BUFFER_SIZE, stdin)) {
-      // something has gone very wrong, likely an issue with stdin
-      perror(NULL);
-      exit(EXIT_STDIN_ERROR);
-    }
+    halma_term_read_line();
 
     if (2 != sscanf(input_buffer, " %c %c", &x_coord, &y_coord)) {
       // we already checked the input stdin, no need to do so again here
@@ -197,6 +279,12 @@ dimension_T halma_select_piece(struct halma_board* board,
       continue;
     }
 
+    // boards smaller than 16 don't use every hex digit
+    if (y_index >= HALMA_SQUARE_ROOT || x_index >= HALMA_SQUARE_ROOT) {
+      printf("Those coordinates are off the board.\n");
+      continue;
+    }
+
     // check to see if given coords are usable
     dimension_T entry_validation =
         halma_validate_piece_selection(board, y_index, x_index, moves, turn);
@@ -228,11 +316,7 @@ int halma_select_target(struct halma_board* board, struct halma_moves* move) {
 
   do {
     printf("Enter coordinates to move to [XY]: ");
-    if (!fgets(input_buffer, INPUT_BUFFER_SIZE, stdin)) {
-      // something has gone very wrong, likely an issue with stdin
-      perror(NULL);
-      exit(EXIT_STDIN_ERROR);
-    }
+    halma_term_read_line();
 
     if (2 != sscanf(input_buffer, " %c%c", &x_coord, &y_coord)) {
       // we already checked the input stdin, no need to do so again here
@@ -248,6 +332,12 @@ int halma_select_target(struct halma_board* board, struct halma_moves* move) {
       continue;
     }
 
+    // boards smaller than 16 don't use every hex digit
+    if (y_index >= HALMA_SQUARE_ROOT || x_index >= HALMA_SQUARE_ROOT) {
+      printf("Those coordinates are off the board.\n");
+      continue;
+    }
+
     if (!halma_validate_target_selection(move, y_index, x_index)) {
       printf("That is not a valid tile to move to.\n");
       continue;
@@ -263,6 +353,8 @@ int halma_select_target(struct halma_board* board, struct halma_moves* move) {
 #define H_NEWLINE "\033[0m\n"
 
 void halma_print_board(struct halma_board* board) {
+  enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT];
+  halma_board_view(board, grid);
   printf(" ");  // Space for left column of numbers
   for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++) printf("%1X", i);
   printf("\n");
@@ -273,7 +365,7 @@ void halma_print_board(struct halma_board* board) {
         printf(B_WHITE);
       else
         printf(B_BLACK);
-      switch (board->grid[i][o]) {
+      switch (grid[i][o]) {
         case RED:
           printf(F_RED);
           break;
@@ -298,14 +390,18 @@ void halma_print_board(struct halma_board* board) {
 bool halma_is_coord_movable(struct halma_board* board,
                             struct halma_moves* moves, dimension_T y_index,
                             dimension_T x_index) {
-  for (dimension_T i = 0; i < board->player_pieces; i++)
-    if (moves[i].origin_y == y_index && moves[i].origin_x == x_index) 
-      if(anybit(moves[i].targets)) return true;
+  dimension_T i = halma_piece_index(board, y_index, x_index);
+  if (i < 0) return false;
+  // the tile could belong to another set, whose pieces aren't in this table
+  if (moves[i].origin_y == y_index && moves[i].origin_x == x_index)
+    if(anybit(moves[i].targets)) return true;
   return false;
 }
 
 void halma_print_movable_pieces(struct halma_board* board,
                                 struct halma_moves* moves) {
+  enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT];
+  halma_board_view(board, grid);
   printf(" ");  // Space for left column of numbers
   for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++) printf("%1X", i);
   printf("\n");
@@ -319,7 +415,7 @@ void halma_print_movable_pieces(struct halma_board* board,
       if (halma_is_coord_movable(board, moves, i, o)) {
         printf(F_PURPLE);
       } else {
-        switch (board->grid[i][o]) {
+        switch (grid[i][o]) {
           case RED:
             printf(F_RED);
             break;
@@ -343,6 +439,8 @@ void halma_print_movable_pieces(struct halma_board* board,
 }
 
 void halma_print_targets(struct halma_board* board, struct halma_moves* move) {
+  enum halma_piece grid[HALMA_SQUARE_ROOT][HALMA_SQUARE_ROOT];
+  halma_board_view(board, grid);
   printf(" ");  // Space for left column of numbers
   for (dimension_T i = 0; i < HALMA_SQUARE_ROOT; i++) printf("%1X", i);
   printf("\n");
@@ -358,7 +456,7 @@ void halma_print_targets(struct halma_board* board, struct halma_moves* move) {
       } else if (i == move->origin_y && o == move->origin_x) {
         printf(F_PURPLE);
       } else {
-        switch (board->grid[i][o]) {
+        switch (grid[i][o]) {
           case RED:
             printf(F_RED);
             break;
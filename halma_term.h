@@ -2,6 +2,7 @@
 #define HALMA_TERM_H_INCLUDED
 
 #include "halma.h"
+#include "halma_engine.h"
 
 void halma_print_board(struct halma_board* board);
 void halma_print_movable_pieces(struct halma_board* board,
@@ -11,9 +12,17 @@ char halma_term_greeting();
 char halma_term_game_menu(enum halma_piece turn);
 char* halma_get_filename();
 void halma_term_filename_perror();
+void halma_term_no_network(const char* filename);
 void halma_no_moves_error(enum halma_piece turn);
 void halma_term_victory(enum halma_piece victor);
 dimension_T halma_get_game_type();
+bool halma_get_computer_opponent();
+void halma_print_computer_move(enum halma_piece turn, halma_move_T move);
+void halma_term_illegal_computer_move(enum halma_piece turn);
+void halma_term_move_rejected(enum halma_piece turn);
+void halma_print_hint(enum halma_piece turn, const struct halma_ranking* hint);
+// idle gets called with arg every so often while waiting for input
+void halma_term_on_idle(void (*idle)(void*), void* arg);
 dimension_T halma_select_piece(struct halma_board* board,
                                struct halma_moves* moves,
                                enum halma_piece turn);
@@ -0,0 +1,152 @@
+#include "halma_tt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define EXIT_MALLOC_ERROR 39
+
+// the low bits of the key pick the bucket, so the whole key is kept in the
+// entry to tell positions that share a bucket apart
+#define tt_bucket(tt, key) (&(tt)->buckets[(key) & (tt)->bucket_mask])
+
+struct halma_tt* halma_tt_create(size_t megabytes) {
+  size_t buckets = 1;
+  if (megabytes < 1) megabytes = 1;
+  while (buckets * 2 * sizeof(struct halma_tt_bucket) <= megabytes << 20)
+    buckets *= 2;
+
+  struct halma_tt* tt = malloc(sizeof(struct halma_tt));
+  if (tt == NULL) exit(EXIT_MALLOC_ERROR);
+  tt->buckets =
+      aligned_alloc(64, buckets * sizeof(struct halma_tt_bucket));
+  if (tt->buckets == NULL) exit(EXIT_MALLOC_ERROR);
+  tt->bucket_mask = buckets - 1;
+  halma_tt_clear(tt);
+  return tt;
+}
+
+void halma_tt_clear(struct halma_tt* tt) {
+  memset(tt->buckets, 0,
+         (tt->bucket_mask + 1) * sizeof(struct halma_tt_bucket));
+  tt->age = 0;
+}
+
+void halma_tt_new_search(struct halma_tt* tt) { tt->age++; }
+
+/**
+ * @brief Packs everything but the key of an entry into one word.
+ */
+static uint64_t tt_pack(const struct halma_tt_entry* entry) {
+  return (uint64_t)(uint16_t)entry->score | ((uint64_t)entry->move << 16) |
+         ((uint64_t)(uint8_t)entry->depth << 32) |
+         ((uint64_t)entry->bound << 40) | ((uint64_t)entry->age << 48);
+}
+
+/**
+ * @brief Reads a slot without locking. If another thread was writing it at
+ * the same time the key comes out wrong, so the entry just won't match
+ * anything. An empty slot comes out with bound HALMA_TT_NONE.
+ */
+static void tt_read(struct halma_tt_slot* slot, struct halma_tt_entry* entry) {
+  uint64_t data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+  uint64_t check = atomic_load_explicit(&slot->check, memory_order_relaxed);
+  entry->key = check ^ data;
+  entry->score = (int16_t)(uint16_t)data;
+  entry->move = (halma_move_T)(data >> 16);
+  entry->depth = (int8_t)(uint8_t)(data >> 32);
+  entry->bound = (uint8_t)(data >> 40);
+  entry->age = (uint8_t)(data >> 48);
+  entry->unused = 0;
+}
+
+static void tt_write(struct halma_tt_slot* slot,
+                     const struct halma_tt_entry* entry) {
+  uint64_t data = tt_pack(entry);
+  atomic_store_explicit(&slot->data, data, memory_order_relaxed);
+  atomic_store_explicit(&slot->check, entry->key ^ data,
+                        memory_order_relaxed);
+}
+
+bool halma_tt_probe(struct halma_tt* tt, uint64_t key,
+                    struct halma_tt_entry* entry,
+                    struct halma_tt_stats* stats) {
+  struct halma_tt_bucket* bucket = tt_bucket(tt, key);
+  if (stats) stats->probes++;
+  for (int i = 0; i < HALMA_TT_BUCKET_ENTRIES; i++) {
+    tt_read(&bucket->slots[i], entry);
+    if (entry->key == key && entry->bound != HALMA_TT_NONE) {
+      if (stats) stats->hits++;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief How much an entry is worth keeping, deep results from the current
+ * search are worth the most. Every search of age counts for as much as 4 ply
+ * of depth.
+ */
+static int tt_worth(struct halma_tt* tt, struct halma_tt_entry* entry) {
+  return entry->depth - (4 * (uint8_t)(tt->age - entry->age));
+}
+
+void halma_tt_store(struct halma_tt* tt, uint64_t key, int score, int depth,
+                    enum halma_tt_bound bound, halma_move_T move,
+                    struct halma_tt_stats* stats) {
+  struct halma_tt_bucket* bucket = tt_bucket(tt, key);
+  struct halma_tt_entry entries[HALMA_TT_BUCKET_ENTRIES];
+  struct halma_tt_entry* slot = NULL;
+  if (stats) stats->stores++;
+
+  for (int i = 0; i < HALMA_TT_BUCKET_ENTRIES; i++)
+    tt_read(&bucket->slots[i], &entries[i]);
+
+  for (int i = 0; i < HALMA_TT_BUCKET_ENTRIES && slot == NULL; i++)
+    if (entries[i].key == key && entries[i].bound != HALMA_TT_NONE) {
+      slot = &entries[i];
+      // a shallower result for the same position is only worth less, unless
+      // it is exact or the old one is from an earlier search
+      if (depth < slot->depth && bound != HALMA_TT_EXACT &&
+          slot->age == tt->age)
+        return;
+      if (move == 0) move = slot->move;
+    }
+
+  if (slot == NULL) {
+    slot = &entries[0];
+    for (int i = 0; i < HALMA_TT_BUCKET_ENTRIES; i++) {
+      if (entries[i].bound == HALMA_TT_NONE) {
+        slot = &entries[i];
+        break;
+      }
+      if (tt_worth(tt, &entries[i]) < tt_worth(tt, slot)) slot = &entries[i];
+    }
+    if (slot->bound != HALMA_TT_NONE && stats) stats->replacements++;
+  }
+
+  slot->key = key;
+  slot->score = score;
+  slot->move = move;
+  slot->depth = depth;
+  slot->bound = bound;
+  slot->age = tt->age;
+  tt_write(&bucket->slots[slot - entries], slot);
+}
+
+int halma_tt_permille(struct halma_tt* tt) {
+  size_t buckets = tt->bucket_mask + 1 < 1000 ? tt->bucket_mask + 1 : 1000;
+  struct halma_tt_entry entry;
+  int used = 0;
+  for (size_t i = 0; i < buckets; i++)
+    for (int o = 0; o < HALMA_TT_BUCKET_ENTRIES; o++) {
+      tt_read(&tt->buckets[i].slots[o], &entry);
+      used += entry.bound != HALMA_TT_NONE;
+    }
+  return (used * 1000) / (buckets * HALMA_TT_BUCKET_ENTRIES);
+}
+
+void halma_tt_destroy(struct halma_tt* tt) {
+  free(tt->buckets);
+  free(tt);
+}
@@ -0,0 +1,140 @@
+#ifndef HALMA_TT_H_INCLUDED
+#define HALMA_TT_H_INCLUDED
+/* halma_tt.h
+ * Transposition table, a fixed size hash table of search results keyed on
+ * board->hash. Entries are grouped into buckets of four that fill exactly one
+ * 64 byte cache line, a probe or a store only ever touches one line.
+ * Any number of threads can probe and store at once without locking. Every
+ * entry is stored as two words, the result packed into one and the key XORed
+ * with it in the other, so an entry half written by another thread doesn't
+ * match its key and is ignored.
+ */
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "halma.h"
+
+#define HALMA_TT_BUCKET_ENTRIES 4
+
+/**
+ * @brief What a stored score means, the search that stored it either got the
+ * exact value or cut off and only knows a bound.
+ */
+enum halma_tt_bound {
+  HALMA_TT_NONE = 0,
+  HALMA_TT_EXACT,
+  HALMA_TT_LOWER,  // score is at least this, the search failed high
+  HALMA_TT_UPPER   // score is at most this, the search failed low
+};
+
+/**
+ * @brief A single search result, as halma_tt_probe hands it out.
+ */
+struct halma_tt_entry {
+  uint64_t key;
+  int16_t score;
+  halma_move_T move;  // best move found, 0 if there wasn't one
+  int8_t depth;
+  uint8_t bound;  // enum halma_tt_bound
+  uint8_t age;    // halma_tt_new_search count when stored
+  uint8_t unused;
+};
+
+/**
+ * @brief How an entry is kept in the table, 16 bytes. data is the entry
+ * without its key packed into one word, check is the key XORed with data.
+ */
+struct halma_tt_slot {
+  _Atomic uint64_t check;
+  _Atomic uint64_t data;
+};
+
+struct halma_tt_bucket {
+  struct halma_tt_slot slots[HALMA_TT_BUCKET_ENTRIES];
+} __attribute__((aligned(64)));
+
+/**
+ * @brief Running counts of how the table is being used. Every thread keeps
+ * its own, a count shared by every thread would have them all fighting over
+ * one cache line.
+ */
+struct halma_tt_stats {
+  unsigned long long probes;
+  unsigned long long hits;
+  unsigned long long stores;
+  // stores that pushed out an entry for a different position
+  unsigned long long replacements;
+};
+
+struct halma_tt {
+  struct halma_tt_bucket* buckets;
+  size_t bucket_mask;  // bucket count - 1, the count is a power of two
+  uint8_t age;
+};
+
+/**
+ * @brief Allocates a table of (at most) the given size. The number of buckets
+ * is rounded down to a power of two so a key can be mapped to a bucket with a
+ * mask.
+ *
+ * @param megabytes how much memory the table can use, at least 1.
+ * @return struct halma_tt* the empty table, on the heap.
+ */
+struct halma_tt* halma_tt_create(size_t megabytes);
+
+/**
+ * @brief Empties the table. No other thread can be using it.
+ */
+void halma_tt_clear(struct halma_tt* tt);
+
+/**
+ * @brief Marks the start of a new search. Entries from older searches are the
+ * first to be replaced. No other thread can be using the table.
+ */
+void halma_tt_new_search(struct halma_tt* tt);
+
+/**
+ * @brief Looks up a position.
+ *
+ * @param tt the table.
+ * @param key hash of the position, see struct halma_board.
+ * @param entry set to the stored entry if there is one.
+ * @param stats the calling thread's counts to add to, can be NULL.
+ * @return true if the position was found.
+ */
+bool halma_tt_probe(struct halma_tt* tt, uint64_t key,
+                    struct halma_tt_entry* entry,
+                    struct halma_tt_stats* stats);
+
+/**
+ * @brief Stores a search result. If the position is already stored it is
+ * overwritten unless the old entry came from a deeper search this time round.
+ * Otherwise it takes an empty entry in the bucket, or the one from the oldest
+ * and shallowest search.
+ *
+ * @param tt the table.
+ * @param key hash of the position.
+ * @param score score to store.
+ * @param depth depth the score was searched to.
+ * @param bound what kind of score it is.
+ * @param move best move found, 0 for none. A 0 keeps the move already stored
+ * for the same position.
+ * @param stats the calling thread's counts to add to, can be NULL.
+ */
+void halma_tt_store(struct halma_tt* tt, uint64_t key, int score, int depth,
+                    enum halma_tt_bound bound, halma_move_T move,
+                    struct halma_tt_stats* stats);
+
+/**
+ * @brief How full the table is, in entries per thousand. Only looks at the
+ * first thousand buckets or so.
+ */
+int halma_tt_permille(struct halma_tt* tt);
+
+/**
+ * @brief Deallocates a table.
+ */
+void halma_tt_destroy(struct halma_tt* tt);
+
+#endif  // HALMA_TT_H_INCLUDED
@@ -1,17 +1,49 @@
 #include <stdio.h>
+#include <unistd.h>
 
 #include "halma.h"
+#include "halma_engine.h"
+#ifdef HALMA_NNUE
+#include "halma_nnue.h"
+#endif
+#include "halma_ponder.h"
 #include "halma_term.h"
 
+// how long the computer opponent gets to think about each move, in seconds
+#define COMPUTER_SECONDS 1.0
+// the network the computer evaluates positions with, in builds that can
+#define NNUE_FILE "halma.nnue"
+
+static void ponder_while_idle(void* ponder) { halma_ponder_idle(ponder); }
+
 int main() {
   struct halma_board* board = NULL;
+  struct halma_all_moves all_moves;
   struct halma_moves* moves = NULL;
   enum halma_piece turn = EMPTY;
+  bool computer = false;
+  // the computer searches with every core there is, for as long as it's
+  // allowed to
+  struct halma_limits computer_limits = {0, 0, HALMA_SEARCH_PARANOID,
+                                         sysconf(_SC_NPROCESSORS_ONLN)};
+  struct halma_search_result computer_move;
+  // thinks ahead while waiting on the person playing, for hints and for the
+  // computer's reply
+  struct halma_ponder* ponder =
+      halma_ponder_create(computer_limits.threads, computer_limits.mode);
+  struct halma_ranking hint;
   dimension_T move_index = 0;
+  dimension_T origin_y, origin_x;
   int target_composite = 0;
   char* filename = NULL;
   bool gameloop, refreshmoves;
 
+  halma_term_on_idle(ponder_while_idle, ponder);
+#ifdef HALMA_NNUE
+  // loaded before any board is set up, so they all get accumulators
+  if (!halma_nnue_load(NNUE_FILE)) halma_term_no_network(NNUE_FILE);
+#endif
+
   // main program loop
   do {
     // main menu
@@ -31,27 +63,64 @@ int main() {
         }
         break;
       case 'Q':
+        halma_ponder_destroy(ponder);
         return 0;
       default:
         return 1;
     }
 
+    // the person playing always has RED, the computer plays everyone else
+    computer = halma_get_computer_opponent();
+    // hints use the engine too
+    halma_engine_new_game();
+
     // gameplay loop
     gameloop = true;
     refreshmoves = true;
+    // move tables for every set are kept around and updated after each move
+    halma_gather_all_moves(board, &all_moves);
     do {
       turn = halma_whos_turn(board);
+      moves = all_moves.sets[halma_set_index(turn)];
       if (refreshmoves) {
-        moves = halma_gather_valid_moves(board, turn);
         if(!halma_any_possible_moves(board,moves))
         {
-          halma_clear_moves(board,moves);
-          moves = NULL;
           halma_no_moves_error(turn);
+          halma_pass_turn(board);
+          continue;
         }
         refreshmoves = false;
+        if (!computer || turn == RED)
+          halma_ponder_set_position(ponder, board, computer);
       }
-      switch (halma_term_game_menu(turn)) {
+      switch (computer && turn != RED ? 'C' : halma_term_game_menu(turn)) {
+        case 'C':
+          halma_ponder_stop(ponder);
+          computer_move = halma_engine_timed_move(board, &computer_limits,
+                                                  COMPUTER_SECONDS);
+          origin_y = halma_square_y(halma_move_from(computer_move.move));
+          origin_x = halma_square_x(halma_move_from(computer_move.move));
+          target_composite = halma_move_to(computer_move.move);
+          halma_print_computer_move(turn, computer_move.move);
+          move_index = halma_piece_index(board, origin_y, origin_x);
+          // a move the engine got wrong would leave the board and the move
+          // tables out of step, so it ends the program instead
+          if (!halma_is_legal_move(board, halma_move_from(computer_move.move),
+                                   target_composite) ||
+              halma_accept_move(board, &moves[move_index],
+                                target_composite / HALMA_SQUARE_ROOT,
+                                target_composite % HALMA_SQUARE_ROOT) < 0) {
+            halma_term_illegal_computer_move(turn);
+            halma_ponder_destroy(ponder);
+            return 3;
+          }
+          halma_update_all_moves(board, &all_moves, origin_y, origin_x,
+                                 target_composite / HALMA_SQUARE_ROOT,
+                                 target_composite % HALMA_SQUARE_ROOT);
+          refreshmoves = true;
+          halma_print_board(board);
+          break;
+
         case 'B':
           halma_print_board(board);
           break;
@@ -70,13 +139,28 @@ int main() {
           move_index = halma_select_piece(board, moves, turn);
           if (move_index < 0) break;
           target_composite = halma_select_target(board, &moves[move_index]);
-          halma_accept_move(board, &moves[move_index],
-                            target_composite / HALMA_SQUARE_ROOT,
-                            target_composite % HALMA_SQUARE_ROOT);
+          origin_y = moves[move_index].origin_y;
+          origin_x = moves[move_index].origin_x;
+          // the board is left alone if the move isn't accepted, so the move
+          // tables are too
+          if (halma_accept_move(board, &moves[move_index],
+                                target_composite / HALMA_SQUARE_ROOT,
+                                target_composite % HALMA_SQUARE_ROOT) < 0) {
+            halma_term_move_rejected(turn);
+            break;
+          }
+          halma_update_all_moves(board, &all_moves, origin_y, origin_x,
+                                 target_composite / HALMA_SQUARE_ROOT,
+                                 target_composite % HALMA_SQUARE_ROOT);
           refreshmoves = true;
           halma_print_board(board);
           break;
 
+        case 'H':
+          halma_ponder_hint(ponder, &hint);
+          halma_print_hint(turn, &hint);
+          break;
+
         case 'S':
           filename = halma_get_filename();
           halma_save_game(filename, board);
@@ -91,9 +175,6 @@ int main() {
       }
 
       if (refreshmoves) {
-        halma_clear_moves(board, moves);
-        moves = NULL;
-
         //we only need to check if someones won after a move
         turn = halma_check_victory_all(board);
         if(turn != EMPTY)
@@ -105,6 +186,9 @@ int main() {
       
     } while (gameloop);
 
+    halma_ponder_stop(ponder);
+
+    halma_clear_all_moves(board, &all_moves);
     halma_end_game(board);
     board = NULL;
   } while (true);